@@ -0,0 +1,145 @@
+#ifndef CHARACTER_EVENTS_CPP
+#define CHARACTER_EVENTS_CPP
+
+// Every change to a character is a small binary event in an append-only
+// log. Events are numbered from 1 and carry the time they were made. Only
+// events that create or replace a whole character carry the record itself.
+// Snapshots of all characters are appended to a second file now and then,
+// so the state at any event is one snapshot plus the events after it.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <unistd.h>
+
+const int CHARACTER_NAME_LENGTH = 32;
+const int RECORD_ATTRIBUTES = 6;
+const int RECORD_STATS = 5;
+
+const int STR_POSITION = 0;
+const int DEX_POSITION = 1;
+const int CON_POSITION = 2;
+const int INT_POSITION = 3;
+const int WIS_POSITION = 4;
+const int CHA_POSITION = 5;
+
+const int HP_POSITION = 0;
+const int ARMOR_POSITION = 1;
+const int LVL_POSITION = 2;
+const int XP_POSITION = 3;
+const int XPNEEDED_POSITION = 4;
+
+// Dungeon World: the next level needs the current level + 7 XP.
+const int XP_NEEDED_OVER_LEVEL = 7;
+
+const uint16_t EVENT_CREATED = 1;
+const uint16_t EVENT_REPLACED = 2;
+const uint16_t EVENT_HP = 3;
+const uint16_t EVENT_XP = 4;
+const uint16_t EVENT_LEVEL_UP = 5;
+
+const char SNAPSHOT_MAGIC[8] = {'D', 'W', 'S', 'N', 'A', 'P', '0', '2'};
+
+struct characterRecord
+{
+  char name[CHARACTER_NAME_LENGTH];
+  int32_t attributes[RECORD_ATTRIBUTES];
+  int32_t stats[RECORD_STATS];
+  // Sequence number of the last event applied to this character.
+  uint32_t lastEvent;
+  // Pads the record to a size that divides the page size, see characterStore.cpp.
+  uint32_t reserved[12];
+};
+
+struct characterEvent
+{
+  int64_t time;
+  uint32_t sequence;
+  uint16_t type;
+  uint16_t payloadSize;
+  uint32_t character;
+  int32_t value;
+  uint32_t checksum;
+  uint32_t reserved;
+};
+
+struct snapshotHeader
+{
+  char magic[8];
+  uint32_t count;
+  uint32_t sequence;
+  uint64_t logOffset;
+  int64_t time;
+};
+
+static_assert(sizeof(characterRecord) == 128, "records are stored as raw bytes");
+static_assert(sizeof(characterEvent) == 32, "events are stored as raw bytes");
+static_assert(sizeof(snapshotHeader) == 32, "snapshot headers are stored as raw bytes");
+
+uint32_t fnv1a(const void *data, const std::size_t size, uint32_t hash = 2166136261u)
+{
+  const unsigned char *bytes = static_cast <const unsigned char *> (data);
+  for(std::size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 16777619u;
+  return hash;
+}
+
+bool eventHasPayload(const uint16_t type) { return type == EVENT_CREATED || type == EVENT_REPLACED; }
+
+// Covers everything before the checksum and the payload, if any.
+uint32_t eventChecksum(const characterEvent &event, const characterRecord &payload)
+{
+  uint32_t hash = fnv1a(&event, offsetof(characterEvent, checksum));
+  return event.payloadSize == 0 ? hash : fnv1a(&payload, sizeof(payload), hash);
+}
+
+std::size_t eventSize(const characterEvent &event) { return sizeof(characterEvent) + event.payloadSize; }
+
+// False at the end of the log and at an entry torn by a crash.
+bool readEvent(const int fd, const off_t offset, characterEvent &event, characterRecord &payload)
+{
+  if(pread(fd, &event, sizeof(event), offset) != (ssize_t)sizeof(event)) return false;
+  if(event.payloadSize != (eventHasPayload(event.type) ? sizeof(characterRecord) : 0)) return false;
+  if(event.payloadSize > 0 && pread(fd, &payload, sizeof(payload), offset + (off_t)sizeof(event)) != (ssize_t)sizeof(payload)) return false;
+  return event.checksum == eventChecksum(event, payload);
+}
+
+// Applies a change to an existing character; creating one is up to the caller.
+void applyChange(characterRecord &record, const characterEvent &event, const characterRecord &payload)
+{
+  switch(event.type)
+  {
+    case EVENT_REPLACED:
+      record = payload;
+      break;
+    case EVENT_HP:
+      record.stats[HP_POSITION] += event.value;
+      break;
+    case EVENT_XP:
+      record.stats[XP_POSITION] += event.value;
+      break;
+    case EVENT_LEVEL_UP:
+      record.stats[XP_POSITION] -= record.stats[XPNEEDED_POSITION];
+      record.stats[LVL_POSITION]++;
+      record.stats[XPNEEDED_POSITION] = record.stats[LVL_POSITION] + XP_NEEDED_OVER_LEVEL;
+      break;
+    default:
+      break;
+  }
+  record.lastEvent = event.sequence;
+}
+
+std::string eventDescription(const characterEvent &event)
+{
+  switch(event.type)
+  {
+    case EVENT_CREATED: return "created";
+    case EVENT_REPLACED: return "replaced";
+    case EVENT_HP: return (event.value >= 0 ? "HP +" : "HP ") + std::to_string(event.value);
+    case EVENT_XP: return (event.value >= 0 ? "XP +" : "XP ") + std::to_string(event.value);
+    case EVENT_LEVEL_UP: return "level up";
+    default: return "unknown";
+  }
+}
+
+#endif
@@ -0,0 +1,379 @@
+#ifndef CHARACTER_STORE_CPP
+#define CHARACTER_STORE_CPP
+
+// Every character of the campaign as a fixed-size record in one
+// memory-mapped file, edited in place. The store is only the current state:
+// each change is first appended to the event log (characterEvents.cpp) and
+// flushed, then applied to the mapping. A crash therefore loses nothing that
+// a change returned from, the next open() replays the log from the last
+// checkpoint. Records remember the last event applied to them, so replaying
+// an event that already reached the disk changes nothing. That relies on
+// lastEvent reaching the disk together with the stats it guards: the header
+// and every record are 128 bytes, so no record straddles a page or a
+// 512-byte sector, and writeback of either is assumed to be all or nothing.
+// The log is never truncated; with the snapshots it can rebuild the
+// characters as they were after any event.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "characterEvents.cpp"
+
+const char STORE_MAGIC[8] = {'D', 'W', 'C', 'H', 'A', 'R', 'S', '3'};
+const uint32_t INITIAL_CAPACITY = 16;
+const uint32_t CHECKPOINT_EVERY = 64;
+const uint32_t SNAPSHOT_EVERY = 1024;
+
+struct storeHeader
+{
+  char magic[8];
+  uint32_t recordSize;
+  uint32_t count;
+  uint32_t capacity;
+  // The last event in the log before replayFrom.
+  uint32_t sequence;
+  // Everything in the log before this offset is applied and synced.
+  uint64_t replayFrom;
+  // Keeps the records that follow aligned to their own size.
+  char reserved[96];
+};
+
+static_assert(sizeof(storeHeader) == sizeof(characterRecord), "the header is stored as raw bytes and takes one record slot");
+static_assert(4096 % sizeof(characterRecord) == 0, "a record must never straddle a page");
+
+std::string recordName(const characterRecord &record)
+{
+  return std::string(record.name, strnlen(record.name, CHARACTER_NAME_LENGTH));
+}
+
+void setRecordName(characterRecord &record, const std::string_view name)
+{
+  std::memset(record.name, 0, CHARACTER_NAME_LENGTH);
+  std::memcpy(record.name, name.data(), name.size() < CHARACTER_NAME_LENGTH ? name.size() : CHARACTER_NAME_LENGTH);
+}
+
+bool writeAll(const int fd, const void *data, std::size_t size)
+{
+  const char *bytes = static_cast <const char *> (data);
+  while(size > 0)
+  {
+    ssize_t written = write(fd, bytes, size);
+    if(written <= 0) return false;
+    bytes += written;
+    size -= (std::size_t)written;
+  }
+  return true;
+}
+
+// Where one snapshot sits in the snapshot file.
+struct snapshotEntry
+{
+  uint32_t sequence;
+  uint32_t count;
+  uint64_t logOffset;
+  off_t offset;
+};
+
+class characterStore
+{
+  public:
+  characterStore() {}
+  characterStore(const characterStore &) = delete;
+  characterStore &operator=(const characterStore &) = delete;
+  ~characterStore() { close(); }
+
+  // Opens or creates the store and replays the log past the last checkpoint.
+  bool open(const std::string &storePath, const std::string &logPath, const std::string &snapshotPath)
+  {
+    close();
+    storeFd = ::open(storePath.c_str(), O_RDWR | O_CREAT, 0644);
+    logFd = ::open(logPath.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    snapshotFd = ::open(snapshotPath.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if(storeFd < 0 || logFd < 0 || snapshotFd < 0) return false;
+    struct stat status;
+    if(fstat(storeFd, &status) != 0) return false;
+    if(status.st_size == 0 && !initialise()) return false;
+    if(!map()) return false;
+    if(std::memcmp(header()->magic, STORE_MAGIC, sizeof(STORE_MAGIC)) != 0 || header()->recordSize != sizeof(characterRecord)) return false;
+    return indexSnapshots() && replayLog();
+  }
+
+  void close()
+  {
+    if(mapping != nullptr)
+    {
+      checkpoint();
+      munmap(mapping, mappedSize);
+    }
+    if(storeFd >= 0) ::close(storeFd);
+    if(logFd >= 0) ::close(logFd);
+    if(snapshotFd >= 0) ::close(snapshotFd);
+    mapping = nullptr;
+    storeFd = -1;
+    logFd = -1;
+    snapshotFd = -1;
+    snapshots.clear();
+  }
+
+  uint32_t count() const { return header()->count; }
+
+  const characterRecord &record(const uint32_t index) const { return records()[index]; }
+
+  // Returns the index of the character with that name, count() if none.
+  uint32_t find(const std::string &name) const
+  {
+    for(uint32_t i = 0; i < count(); i++) if(recordName(records()[i]) == name) return i;
+    return count();
+  }
+
+  // The number of the last event in the log.
+  uint32_t lastEvent() const { return nextSequence - 1; }
+
+  // Every change below is durable once it returns true.
+  bool append(const characterRecord &added) { return appendAll(std::vector <characterRecord> (1, added)); }
+
+  // Appends many characters behind a single log flush.
+  bool appendAll(const std::vector <characterRecord> &added)
+  {
+    std::vector <characterEvent> events(added.size());
+    for(std::size_t i = 0; i < added.size(); i++) events[i] = makeEvent(EVENT_CREATED, count() + (uint32_t)i, 0);
+    return logAndApply(events, added);
+  }
+
+  bool update(const uint32_t index, const characterRecord &changed)
+  {
+    return index < count() && logAndApply(std::vector <characterEvent> (1, makeEvent(EVENT_REPLACED, index, 0)), std::vector <characterRecord> (1, changed));
+  }
+
+  bool changeHp(const uint32_t index, const int32_t change) { return change != 0 && logChange(EVENT_HP, index, change); }
+
+  bool gainXp(const uint32_t index, const int32_t xp) { return xp != 0 && logChange(EVENT_XP, index, xp); }
+
+  // Fails when the character does not have the XP for the next level.
+  bool levelUp(const uint32_t index)
+  {
+    return index < count() && records()[index].stats[XP_POSITION] >= records()[index].stats[XPNEEDED_POSITION] && logChange(EVENT_LEVEL_UP, index, 1);
+  }
+
+  // Syncs the mapped store so the log before this point is never replayed
+  // again, and appends a snapshot when enough events have passed.
+  void checkpoint()
+  {
+    if(mapping == nullptr || header()->sequence == lastEvent()) return;
+    if(msync(mapping, mappedSize, MS_SYNC) != 0) return;
+    header()->replayFrom = (uint64_t)logEnd;
+    header()->sequence = lastEvent();
+    msync(mapping, sizeof(storeHeader), MS_SYNC);
+    if(lastEvent() - snapshots.back().sequence >= SNAPSHOT_EVERY) appendSnapshot();
+  }
+
+  // Calls onEvent(event, payload) for every event in the log.
+  template <typename OnEvent>
+  void forEachEvent(OnEvent onEvent) const
+  {
+    characterEvent event;
+    characterRecord payload;
+    for(off_t offset = 0; offset < logEnd && readEvent(logFd, offset, event, payload); offset += (off_t)eventSize(event)) onEvent(event, payload);
+  }
+
+  // The characters as they were right after event `sequence`, rebuilt from
+  // the newest snapshot before it and the events that follow it.
+  bool reconstruct(const uint32_t sequence, std::vector <characterRecord> &state) const
+  {
+    std::size_t s = snapshots.size() - 1;
+    while(snapshots[s].sequence > sequence) s--;
+    state.resize(snapshots[s].count);
+    std::size_t bytes = state.size() * sizeof(characterRecord);
+    if(bytes > 0 && pread(snapshotFd, state.data(), bytes, snapshots[s].offset + (off_t)sizeof(snapshotHeader)) != (ssize_t)bytes) return false;
+    characterEvent event;
+    characterRecord payload;
+    for(off_t offset = (off_t)snapshots[s].logOffset; offset < logEnd && readEvent(logFd, offset, event, payload); offset += (off_t)eventSize(event))
+    {
+      if(event.sequence > sequence) break;
+      if(event.type == EVENT_CREATED)
+      {
+        state.push_back(payload);
+        state.back().lastEvent = event.sequence;
+      }else if(event.character < state.size()) applyChange(state[event.character], event, payload);
+    }
+    return true;
+  }
+
+  private:
+  int storeFd = -1;
+  int logFd = -1;
+  int snapshotFd = -1;
+  void *mapping = nullptr;
+  std::size_t mappedSize = 0;
+  off_t logEnd = 0;
+  uint32_t nextSequence = 1;
+  // snapshots[0] is the empty campaign before the first event.
+  std::vector <snapshotEntry> snapshots;
+
+  storeHeader *header() const { return static_cast <storeHeader *> (mapping); }
+
+  characterRecord *records() const { return reinterpret_cast <characterRecord *> (static_cast <char *> (mapping) + sizeof(storeHeader)); }
+
+  static std::size_t fileSize(const uint32_t capacity) { return sizeof(storeHeader) + capacity * sizeof(characterRecord); }
+
+  bool initialise()
+  {
+    storeHeader fresh;
+    std::memset(&fresh, 0, sizeof(fresh));
+    std::memcpy(fresh.magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+    fresh.recordSize = sizeof(characterRecord);
+    fresh.capacity = INITIAL_CAPACITY;
+    if(ftruncate(storeFd, (off_t)fileSize(INITIAL_CAPACITY)) != 0) return false;
+    if(pwrite(storeFd, &fresh, sizeof(fresh), 0) != (ssize_t)sizeof(fresh)) return false;
+    return fsync(storeFd) == 0;
+  }
+
+  bool map()
+  {
+    struct stat status;
+    if(fstat(storeFd, &status) != 0 || (std::size_t)status.st_size < sizeof(storeHeader)) return false;
+    mappedSize = (std::size_t)status.st_size;
+    mapping = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, storeFd, 0);
+    if(mapping == MAP_FAILED)
+    {
+      mapping = nullptr;
+      return false;
+    }
+    return fileSize(header()->capacity) <= mappedSize;
+  }
+
+  // Doubles the capacity; the mapping moves, so no record reference may be
+  // held across an append.
+  bool grow()
+  {
+    uint32_t capacity = header()->capacity * 2;
+    if(msync(mapping, mappedSize, MS_SYNC) != 0) return false;
+    munmap(mapping, mappedSize);
+    mapping = nullptr;
+    if(ftruncate(storeFd, (off_t)fileSize(capacity)) != 0 || !map()) return false;
+    header()->capacity = capacity;
+    return true;
+  }
+
+  characterEvent makeEvent(const uint16_t type, const uint32_t character, const int32_t value)
+  {
+    characterEvent event;
+    std::memset(&event, 0, sizeof(event));
+    event.time = (int64_t)std::time(nullptr);
+    event.type = type;
+    event.payloadSize = eventHasPayload(type) ? sizeof(characterRecord) : 0;
+    event.character = character;
+    event.value = value;
+    return event;
+  }
+
+  bool logChange(const uint16_t type, const uint32_t index, const int32_t value)
+  {
+    return index < count() && logAndApply(std::vector <characterEvent> (1, makeEvent(type, index, value)), std::vector <characterRecord> (1));
+  }
+
+  // Numbers the events, writes them with one flush and applies them.
+  // payloads[i] goes with events[i] when that event carries a record.
+  bool logAndApply(std::vector <characterEvent> events, const std::vector <characterRecord> &payloads)
+  {
+    std::vector <char> buffer;
+    buffer.reserve(events.size() * (sizeof(characterEvent) + sizeof(characterRecord)));
+    for(std::size_t i = 0; i < events.size(); i++)
+    {
+      events[i].sequence = nextSequence + (uint32_t)i;
+      events[i].checksum = eventChecksum(events[i], payloads[i]);
+      const char *event = reinterpret_cast <const char *> (&events[i]);
+      buffer.insert(buffer.end(), event, event + sizeof(characterEvent));
+      const char *payload = reinterpret_cast <const char *> (&payloads[i]);
+      buffer.insert(buffer.end(), payload, payload + events[i].payloadSize);
+    }
+    if(!writeAll(logFd, buffer.data(), buffer.size()) || fdatasync(logFd) != 0) return false;
+    logEnd += (off_t)buffer.size();
+    nextSequence += (uint32_t)events.size();
+    for(std::size_t i = 0; i < events.size(); i++) if(!apply(events[i], payloads[i])) return false;
+    if(lastEvent() - header()->sequence >= CHECKPOINT_EVERY) checkpoint();
+    return true;
+  }
+
+  // Skips events the record already has, which makes replay idempotent.
+  bool apply(const characterEvent &event, const characterRecord &payload)
+  {
+    if(event.character > count()) return false;
+    if(event.character < count() && records()[event.character].lastEvent >= event.sequence) return true;
+    if(event.type != EVENT_CREATED)
+    {
+      if(event.character == count()) return false;
+      applyChange(records()[event.character], event, payload);
+      return true;
+    }
+    if(event.character == header()->capacity && !grow()) return false;
+    records()[event.character] = payload;
+    records()[event.character].lastEvent = event.sequence;
+    if(event.character == count()) header()->count = event.character + 1;
+    return true;
+  }
+
+  // Applies every complete event past the checkpoint; a torn event at the
+  // end is a change that never returned and is cut off.
+  bool replayLog()
+  {
+    struct stat status;
+    if(fstat(logFd, &status) != 0 || (uint64_t)status.st_size < header()->replayFrom) return false;
+    logEnd = (off_t)header()->replayFrom;
+    nextSequence = header()->sequence + 1;
+    characterEvent event;
+    characterRecord payload;
+    while(readEvent(logFd, logEnd, event, payload) && event.sequence == nextSequence)
+    {
+      if(!apply(event, payload)) return false;
+      logEnd += (off_t)eventSize(event);
+      nextSequence++;
+    }
+    if(ftruncate(logFd, logEnd) != 0) return false;
+    checkpoint();
+    return true;
+  }
+
+  bool indexSnapshots()
+  {
+    snapshots.assign(1, snapshotEntry{0, 0, 0, 0});
+    snapshotHeader snapshot;
+    off_t offset = 0;
+    while(pread(snapshotFd, &snapshot, sizeof(snapshot), offset) == (ssize_t)sizeof(snapshot))
+    {
+      if(std::memcmp(snapshot.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) break;
+      off_t end = offset + (off_t)(sizeof(snapshot) + snapshot.count * sizeof(characterRecord));
+      struct stat status;
+      if(fstat(snapshotFd, &status) != 0 || end > status.st_size) break;
+      snapshots.push_back(snapshotEntry{snapshot.sequence, snapshot.count, snapshot.logOffset, offset});
+      offset = end;
+    }
+    return ftruncate(snapshotFd, offset) == 0;
+  }
+
+  void appendSnapshot()
+  {
+    struct stat status;
+    if(fstat(snapshotFd, &status) != 0) return;
+    snapshotHeader snapshot;
+    std::memset(&snapshot, 0, sizeof(snapshot));
+    std::memcpy(snapshot.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    snapshot.count = count();
+    snapshot.sequence = lastEvent();
+    snapshot.logOffset = (uint64_t)logEnd;
+    snapshot.time = (int64_t)std::time(nullptr);
+    // A partial snapshot is cut off by indexSnapshots() at the next open.
+    if(!writeAll(snapshotFd, &snapshot, sizeof(snapshot)) || !writeAll(snapshotFd, records(), count() * sizeof(characterRecord)) || fdatasync(snapshotFd) != 0) return;
+    snapshots.push_back(snapshotEntry{snapshot.sequence, snapshot.count, snapshot.logOffset, status.st_size});
+  }
+};
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef COMBAT_CPP
+#define COMBAT_CPP
+
+// Monte Carlo fights between a character and one monster. Every round the
+// character makes the hack and slash move, 2d6 plus the modifier of the
+// chosen attribute: on 10+ they deal damage and avoid the counterattack,
+// on 7-9 both sides deal damage, on 6- only the monster does. Armor is
+// subtracted from every hit. The fights are split over threads, each with
+// its own generator and histograms, which are merged at the end.
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "characterStore.cpp"
+#include "dice.cpp"
+
+const int FULL_SUCCESS = 10;
+const int PARTIAL_SUCCESS = 7;
+const int DEFAULT_MAX_ROUNDS = 100;
+
+struct encounter
+{
+  int monsterHp = 10;
+  int monsterArmor = 1;
+  dice monsterDamage = {1, 8, 0};
+  dice heroDamage = {1, 8, 0};
+  dice move = {2, 6, 0};
+  int attribute = STR_POSITION;
+  int maxRounds = DEFAULT_MAX_ROUNDS;
+};
+
+struct fightOutcomes
+{
+  uint64_t fights = 0;
+  uint64_t wins = 0;
+  uint64_t losses = 0;
+  // Fights that hit maxRounds with both sides standing.
+  uint64_t timeouts = 0;
+  // rounds[r] - fights decided in round r.
+  std::vector <uint64_t> rounds;
+  // hpLeft[h] - won fights the character finished with h HP.
+  std::vector <uint64_t> hpLeft;
+
+  fightOutcomes(const int maxRounds, const int heroHp) : rounds((std::size_t)maxRounds + 1), hpLeft(heroHp > 0 ? (std::size_t)heroHp + 1 : 1) {}
+
+  void add(const fightOutcomes &other)
+  {
+    fights += other.fights;
+    wins += other.wins;
+    losses += other.losses;
+    timeouts += other.timeouts;
+    for(std::size_t i = 0; i < rounds.size(); i++) rounds[i] += other.rounds[i];
+    for(std::size_t i = 0; i < hpLeft.size(); i++) hpLeft[i] += other.hpLeft[i];
+  }
+};
+
+int damageThrough(xoshiro256 &generator, const dice &damage, const int armor)
+{
+  int dealt = rollDice(generator, damage) - armor;
+  return dealt > 0 ? dealt : 0;
+}
+
+void fight(xoshiro256 &generator, const characterRecord &hero, const encounter &setup, fightOutcomes &outcomes)
+{
+  const int modifier = attributeModifier(hero.attributes[setup.attribute]);
+  const int heroArmor = hero.stats[ARMOR_POSITION];
+  int heroHp = hero.stats[HP_POSITION];
+  int monsterHp = setup.monsterHp;
+  int round = 0;
+  while(heroHp > 0 && monsterHp > 0 && round < setup.maxRounds)
+  {
+    round++;
+    int roll = rollDice(generator, setup.move) + modifier;
+    if(roll >= PARTIAL_SUCCESS) monsterHp -= damageThrough(generator, setup.heroDamage, setup.monsterArmor);
+    if(roll < FULL_SUCCESS && monsterHp > 0) heroHp -= damageThrough(generator, setup.monsterDamage, heroArmor);
+  }
+  outcomes.fights++;
+  outcomes.rounds[(std::size_t)round]++;
+  if(monsterHp <= 0)
+  {
+    outcomes.wins++;
+    if(heroHp > 0) outcomes.hpLeft[(std::size_t)heroHp]++;
+  }else if(heroHp <= 0) outcomes.losses++;
+  else outcomes.timeouts++;
+}
+
+// Counts into a local copy so the threads never share a cache line.
+void fightWorker(const characterRecord &hero, const encounter &setup, const uint64_t fights, const uint64_t seed, fightOutcomes &outcomes)
+{
+  xoshiro256 generator(seed);
+  fightOutcomes local = outcomes;
+  for(uint64_t i = 0; i < fights; i++) fight(generator, hero, setup, local);
+  outcomes = local;
+}
+
+// More threads than cores or than fights would only add start-up cost.
+fightOutcomes simulateFights(const characterRecord &hero, const encounter &setup, const uint64_t fights, unsigned int threads, const uint64_t seed)
+{
+  const unsigned int cores = std::thread::hardware_concurrency();
+  if(cores > 0 && threads > cores) threads = cores;
+  if(threads > fights) threads = (unsigned int)fights;
+  if(threads == 0) threads = 1;
+  std::vector <fightOutcomes> partial(threads, fightOutcomes(setup.maxRounds, hero.stats[HP_POSITION]));
+  std::vector <std::thread> pool;
+  for(unsigned int t = 0; t < threads; t++)
+  {
+    uint64_t share = fights / threads + (t < fights % threads);
+    pool.emplace_back(fightWorker, std::cref(hero), std::cref(setup), share, seed + t * 0xd1b54a32d192ed03ULL, std::ref(partial[t]));
+  }
+  fightOutcomes total(setup.maxRounds, hero.stats[HP_POSITION]);
+  for(unsigned int t = 0; t < threads; t++)
+  {
+    pool[t].join();
+    total.add(partial[t]);
+  }
+  return total;
+}
+
+double percentOf(const uint64_t part, const uint64_t whole) { return whole == 0 ? 0.0 : 100.0 * (double)part / (double)whole; }
+
+// Smallest value whose cumulative count reaches the given share of total.
+std::size_t histogramQuantile(const std::vector <uint64_t> &histogram, const uint64_t total, const double share)
+{
+  uint64_t cumulative = 0;
+  for(std::size_t i = 0; i < histogram.size(); i++)
+  {
+    cumulative += histogram[i];
+    if((double)cumulative >= share * (double)total) return i;
+  }
+  return histogram.size() - 1;
+}
+
+void printOutcomes(const std::string &name, const fightOutcomes &outcomes)
+{
+  std::cout << std::fixed << std::setprecision(1) << name << ": win " << percentOf(outcomes.wins, outcomes.fights)
+  << "%, lose " << percentOf(outcomes.losses, outcomes.fights) << "%, undecided " << percentOf(outcomes.timeouts, outcomes.fights) << "%" << std::endl;
+  std::cout << "  rounds: median " << histogramQuantile(outcomes.rounds, outcomes.fights, 0.5)
+  << ", 90% within " << histogramQuantile(outcomes.rounds, outcomes.fights, 0.9) << std::endl;
+  std::cout << "  rounds to decide:";
+  for(std::size_t r = 1; r < outcomes.rounds.size(); r++)
+  {
+    if(percentOf(outcomes.rounds[r], outcomes.fights) >= 0.5) std::cout << " " << r << ":" << percentOf(outcomes.rounds[r], outcomes.fights) << "%";
+  }
+  std::cout << std::endl;
+  if(outcomes.wins == 0) return;
+  std::cout << "  HP left after a win:";
+  for(std::size_t h = 0; h < outcomes.hpLeft.size(); h++)
+  {
+    if(outcomes.hpLeft[h] > 0) std::cout << " " << h << ":" << percentOf(outcomes.hpLeft[h], outcomes.wins) << "%";
+  }
+  std::cout << std::endl;
+}
+
+#endif
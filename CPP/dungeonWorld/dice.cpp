@@ -0,0 +1,127 @@
+#ifndef DICE_CPP
+#define DICE_CPP
+
+// Dice expressions such as "2d6+1", "d8" or "3", and a fast generator to
+// roll them with. A die is rolled by scaling 32 random bits to the number
+// of sides with a multiply, so every 64-bit draw gives two dice.
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+const int MAX_DICE = 64;
+const int MAX_SIDES = 1000;
+
+uint64_t splitmix64(uint64_t &state)
+{
+  uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+struct xoshiro256
+{
+  uint64_t s[4];
+
+  explicit xoshiro256(uint64_t seed)
+  {
+    for(int i = 0; i < 4; i++) s[i] = splitmix64(seed);
+  }
+
+  static uint64_t rotateLeft(const uint64_t x, const int k) { return (x << k) | (x >> (64 - k)); }
+
+  uint64_t operator()()
+  {
+    const uint64_t result = rotateLeft(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotateLeft(s[3], 45);
+    return result;
+  }
+};
+
+struct dice
+{
+  int count = 0;
+  int sides = 0;
+  int modifier = 0;
+
+  int lowest() const { return count + modifier; }
+  int highest() const { return count * sides + modifier; }
+};
+
+bool parseNumber(std::string_view &text, int &value)
+{
+  std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+  if(result.ec != std::errc()) return false;
+  text.remove_prefix((std::size_t)(result.ptr - text.data()));
+  return true;
+}
+
+// Accepts [count]d<sides>[+-modifier] or a bare number.
+bool parseDice(std::string_view text, dice &parsed)
+{
+  parsed = dice();
+  std::size_t d = text.find('d');
+  if(d == std::string_view::npos) return parseNumber(text, parsed.modifier) && text.empty();
+  parsed.count = 1;
+  std::string_view count = text.substr(0, d);
+  if(!count.empty() && (!parseNumber(count, parsed.count) || !count.empty())) return false;
+  text.remove_prefix(d + 1);
+  if(!parseNumber(text, parsed.sides)) return false;
+  if(!text.empty())
+  {
+    int sign = text.front() == '-' ? -1 : 1;
+    if(text.front() != '+' && text.front() != '-') return false;
+    text.remove_prefix(1);
+    if(!parseNumber(text, parsed.modifier) || !text.empty() || parsed.modifier < 0) return false;
+    parsed.modifier *= sign;
+  }
+  return parsed.count >= 1 && parsed.count <= MAX_DICE && parsed.sides >= 1 && parsed.sides <= MAX_SIDES;
+}
+
+std::string diceToString(const dice &d)
+{
+  std::string text;
+  if(d.count > 0) text = std::to_string(d.count) + "d" + std::to_string(d.sides);
+  if(d.modifier > 0 && d.count > 0) text += "+";
+  if(d.modifier != 0 || d.count == 0) text += std::to_string(d.modifier);
+  return text;
+}
+
+int dieFrom32Bits(const uint64_t bits, const int sides)
+{
+  return 1 + (int)(((bits & 0xffffffffULL) * (uint64_t)sides) >> 32);
+}
+
+int rollDice(xoshiro256 &generator, const dice &d)
+{
+  int total = d.modifier;
+  for(int pairs = d.count / 2; pairs > 0; pairs--)
+  {
+    uint64_t bits = generator();
+    total += dieFrom32Bits(bits, d.sides) + dieFrom32Bits(bits >> 32, d.sides);
+  }
+  if(d.count % 2 == 1) total += dieFrom32Bits(generator(), d.sides);
+  return total;
+}
+
+// Dungeon World's modifier for an attribute score.
+int attributeModifier(const int score)
+{
+  if(score <= 3) return -3;
+  if(score <= 5) return -2;
+  if(score <= 8) return -1;
+  if(score <= 12) return 0;
+  if(score <= 15) return 1;
+  if(score <= 17) return 2;
+  return 3;
+}
+
+#endif
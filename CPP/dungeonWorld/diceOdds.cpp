@@ -0,0 +1,88 @@
+#ifndef DICE_ODDS_CPP
+#define DICE_ODDS_CPP
+
+// Exact distributions of dice totals. Adding one die with s sides to a
+// distribution is a convolution with s equal weights, which is a sliding
+// window sum, so NdS costs O(N * N * S) with no FFT needed. Each NdS is
+// computed once and cached together with its tail sums; a modifier only
+// shifts the total, so every query after that is a lookup.
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "dice.cpp"
+
+struct diceDistribution
+{
+  int lowest = 0;
+  // probability[i] - chance the total is lowest + i.
+  std::vector <double> probability;
+  // atLeast[i] - chance the total is lowest + i or more.
+  std::vector <double> atLeast;
+
+  double chanceAtLeast(const int total) const
+  {
+    if(total <= lowest) return 1.0;
+    std::size_t i = (std::size_t)(total - lowest);
+    return i < atLeast.size() ? atLeast[i] : 0.0;
+  }
+
+  double chanceAtMost(const int total) const { return 1.0 - chanceAtLeast(total + 1); }
+
+  double chanceOf(const int total) const { return chanceAtLeast(total) - chanceAtLeast(total + 1); }
+};
+
+// Distribution of count dice with the given sides, no modifier.
+diceDistribution exactDistribution(const int count, const int sides)
+{
+  diceDistribution result;
+  result.probability.assign(1, 1.0);
+  std::vector <double> next;
+  for(int die = 0; die < count; die++)
+  {
+    next.assign(result.probability.size() + (std::size_t)sides - 1, 0.0);
+    double window = 0;
+    for(std::size_t j = 0; j < next.size(); j++)
+    {
+      if(j < result.probability.size()) window += result.probability[j];
+      if(j >= (std::size_t)sides) window -= result.probability[j - (std::size_t)sides];
+      next[j] = window / sides;
+    }
+    result.probability.swap(next);
+    result.lowest++;
+  }
+  result.atLeast.resize(result.probability.size());
+  double tail = 0;
+  for(std::size_t i = result.probability.size(); i > 0; i--)
+  {
+    tail += result.probability[i - 1];
+    result.atLeast[i - 1] = tail;
+  }
+  return result;
+}
+
+class diceOdds
+{
+  public:
+  // The cached distribution of the dice without their modifier.
+  const diceDistribution &distribution(const dice &d)
+  {
+    dice base = d;
+    base.modifier = 0;
+    std::string key = diceToString(base);
+    std::unordered_map <std::string, diceDistribution>::iterator found = cache.find(key);
+    if(found == cache.end()) found = cache.emplace(key, exactDistribution(d.count, d.sides)).first;
+    return found->second;
+  }
+
+  double chanceAtLeast(const dice &d, const int total) { return distribution(d).chanceAtLeast(total - d.modifier); }
+
+  double chanceAtMost(const dice &d, const int total) { return distribution(d).chanceAtMost(total - d.modifier); }
+
+  double chanceOf(const dice &d, const int total) { return distribution(d).chanceOf(total - d.modifier); }
+
+  private:
+  std::unordered_map <std::string, diceDistribution> cache;
+};
+
+#endif
@@ -2,36 +2,47 @@
 #include <fstream>
 #include <vector>
 #include <string>
+#include <chrono>
+#include <ctime>
+#include <random>
+#include "characterStore.cpp"
+#include "sheetParser.cpp"
+#include "combat.cpp"
+#include "diceOdds.cpp"
+#include "terminal.cpp"
 const int STAT_LENGTH = 3;
 const int NUMBER_OF_ATTRIBUTES_IN_DUNGEON_WORLD = 6;
 const int NUMBER_OF_STATS_IN_DUNGEON_WORLD = 5;
 const char STAT_SEPARATOR = ' ';
 
-const int STR_POSITION = 0;
-const int DEX_POSITION = 1;
-const int CON_POSITION = 2;
-const int INT_POSITION = 3;
-const int WIS_POSITION = 4;
-const int CHA_POSITION = 5;
-
-const int HP_POSITION = 0;
-const int ARMOR_POSITION = 1;
-const int LVL_POSITION = 2;
-const int XP_POSITION = 3;
-const int XPNEEDED_POSITION = 4;
-
 const int QUIT = 0;
 const int CHANGE_HP_CODE = 1;
-const std::string MENU = "What do you want to do? \n 0. QUIT \n 1. Change HP";
-
-
-
-void print(const std::string s)
+const int SWITCH_CHARACTER_CODE = 2;
+const int GAIN_XP_CODE = 3;
+const int LEVEL_UP_CODE = 4;
+const std::string MENU = "0 quit  1 change HP  2 go to character  3 gain XP  4 level up  up/down/j/k select";
+const int LIST_WIDTH = 36;
+const int MAX_NUMBER_INPUT = 6;
+
+const std::string STATS_FILE = "stats.txt";
+const std::string STORE_FILE = "characters.bin";
+const std::string LOG_FILE = "characters.log";
+const std::string SNAPSHOT_FILE = "characters.snapshots";
+const std::string IMPORT_COMMAND = "import";
+const std::string FIGHT_COMMAND = "fight";
+const std::string ODDS_COMMAND = "odds";
+const std::string HISTORY_COMMAND = "history";
+const std::string AT_COMMAND = "at";
+const uint64_t DEFAULT_FIGHTS = 1000000;
+
+
+
+void print(const std::string &s)
 {
   std::cout << s << std::endl;
 }
 
-void printNoEndline(const std::string s)
+void printNoEndline(const std::string &s)
 {
   std::cout << s << " ";
 }
@@ -41,7 +52,7 @@ void printInt(const int i)
   std::cout << i << std::endl;
 }
 
-void printIntInfo(const std::string s, const int i)
+void printIntInfo(const std::string &s, const int i)
 {
   printNoEndline(s);
   printInt(i);
@@ -59,13 +70,13 @@ std::string enterString()
   return s;
 }
 
-std::string printAndEnterString(const std::string s)
+std::string printAndEnterString(const std::string &s)
 {
   print(s);
   return enterString();
 }
 
-void printStringVector(const std::vector <std::string> v)
+void printStringVector(const std::vector <std::string> &v)
 {
   for(unsigned int i = 0; i < v.size(); i++) print(v[i]);
 }
@@ -75,7 +86,7 @@ bool isNumber(const char c)
   return (c >= '0' && c <= '9');
 }
 
-int changeHpLogic(const std::string changeS)
+int changeHpLogic(const std::string &changeS)
 {
   char c = changeS[0];
   if(!isNumber(c))
@@ -86,11 +97,6 @@ int changeHpLogic(const std::string changeS)
 
 }
 
-int changeHp(int hp)
-{
-  return hp + changeHpLogic(printAndEnterString("Enter hp change: ('+' for positive, '' or '-' for negative):"));
-}
-
 int calculateHp(int constitution) { return constitution + 8; }
 
 std::vector <std::string> fileToVector(std::ifstream &file)
@@ -108,7 +114,7 @@ std::vector <std::string> fileToVector(std::ifstream &file)
 	return strings;
 }
 
-void vectorToFile(const std::vector <std::string> strings, std::ofstream &file)
+void vectorToFile(const std::vector <std::string> &strings, std::ofstream &file)
 {
 	for(unsigned int i = 0; i < strings.size(); i++)
 	{
@@ -116,46 +122,17 @@ void vectorToFile(const std::vector <std::string> strings, std::ofstream &file)
 	}
 }
 
-std::vector <std::pair <std::string, int> > stringToAttributes(const std::vector <std::string> stats)
-{
-  std::vector <std::pair <std::string, int> > statsAndValues(NUMBER_OF_ATTRIBUTES_IN_DUNGEON_WORLD);
-  for(int i = 0; i < NUMBER_OF_ATTRIBUTES_IN_DUNGEON_WORLD; i++)
-  {
-
-    std::string currentString = stats[i];
-    statsAndValues[i].first = currentString.substr(0, STAT_LENGTH);
-    std::size_t findSpace = currentString.find(STAT_SEPARATOR);
-    statsAndValues[i].second = std::stoi(currentString.substr(findSpace + 1));
-  }
-  return statsAndValues;
-}
-
-std::vector <std::pair <std::string, int> > stringToStats(const std::vector <std::string> stats)
-{
-  std::vector <std::pair <std::string, int> > statsAndValues(NUMBER_OF_STATS_IN_DUNGEON_WORLD);
-
-  for(int i = NUMBER_OF_ATTRIBUTES_IN_DUNGEON_WORLD; i < NUMBER_OF_ATTRIBUTES_IN_DUNGEON_WORLD + NUMBER_OF_STATS_IN_DUNGEON_WORLD; i++)
-  {
-
-    std::string currentString = stats[i];
-    std::size_t findSpace = currentString.find(STAT_SEPARATOR);
-    statsAndValues[i - NUMBER_OF_ATTRIBUTES_IN_DUNGEON_WORLD].first = currentString.substr(0, findSpace);
-    statsAndValues[i - NUMBER_OF_ATTRIBUTES_IN_DUNGEON_WORLD].second = std::stoi(currentString.substr(findSpace + 1));
-  }
-  return statsAndValues;
-}
-
-void printPair(const std::pair <std::string, int> pair)
+void printPair(const std::pair <std::string, int> &pair)
 {
   printIntInfo(pair.first, pair.second);
 }
 
-void printPairVector(const std::vector <std::pair <std::string, int> > v)
+void printPairVector(const std::vector <std::pair <std::string, int> > &v)
 {
   for(unsigned int i = 0; i < v.size(); i++) printPair(v[i]);
 }
 
-std::vector <std::pair <std::string, int> > attributesAndStatsTogether(const std::vector <std::pair <std::string, int> > attributesNumbers, const std::vector <std::pair <std::string, int> > statsNumbers)
+std::vector <std::pair <std::string, int> > attributesAndStatsTogether(const std::vector <std::pair <std::string, int> > &attributesNumbers, const std::vector <std::pair <std::string, int> > &statsNumbers)
 {
   std::vector <std::pair <std::string, int> > v;
   v.reserve( attributesNumbers.size() + statsNumbers.size() );
@@ -164,7 +141,7 @@ std::vector <std::pair <std::string, int> > attributesAndStatsTogether(const std
   return v;
 }
 
-std::vector <std::string> pairToStringVector(const std::vector <std::pair <std::string, int> > v)
+std::vector <std::string> pairToStringVector(const std::vector <std::pair <std::string, int> > &v)
 {
   std::vector <std::string> stringVector;
   stringVector.reserve(v.size());
@@ -179,14 +156,14 @@ int charToInt(const char c) { return c - '0'; }
 
 bool charIsNumber(const char c) { return c >= '0' && c <= '9'; }
 
-void printNotValidStringLength(const std::string s, const long unsigned int desiredLength)
+void printNotValidStringLength(const std::string &s, const long unsigned int desiredLength)
 {
 	std::cout << "String: \"" << s << "\" is too short/too long, it is: "
 	<< s.length() << " characters long but should be: " << desiredLength
 	<< " characters long " << std::endl;
 }
 
-bool validStringLength(const std::string s, const long unsigned int desiredLength)
+bool validStringLength(const std::string &s, const long unsigned int desiredLength)
 {
 	if(s.length() != desiredLength)
 	{
@@ -196,63 +173,265 @@ bool validStringLength(const std::string s, const long unsigned int desiredLengt
 	return 1;
 }
 
-bool checkMenu(const std::string input)
+bool checkMenu(const std::string &input)
 {
 	if(!validStringLength(input, 1)) return 0;
 	if(!charIsNumber(input.at(0))) return 0;
 	return 1;
 }
 
-void printAttributesAndStats(const std::vector <std::pair <std::string, int> > attributesNumbers, const std::vector <std::pair <std::string, int> > statsNumbers)
+void printAttributesAndStats(const std::vector <std::pair <std::string, int> > &attributesNumbers, const std::vector <std::pair <std::string, int> > &statsNumbers)
 {
   printPairVector(attributesNumbers);
   std::cout << std::endl;
   printPairVector(statsNumbers);
 }
 
-int inputMenu(const std::vector <std::pair <std::string, int> > attributesNumbers, const std::vector <std::pair <std::string, int> > statsNumbers)
+// Imports every sheet in the file; unnamed sheets are named after the file.
+bool importSheets(characterStore &store, const std::string &path)
+{
+  std::string buffer;
+  if(!readWholeFile(path, buffer)) return 0;
+  std::size_t slash = path.find_last_of('/');
+  std::string stem = path.substr(slash == std::string::npos ? 0 : slash + 1);
+  stem = stem.substr(0, stem.find('.'));
+  std::vector <characterRecord> records;
+  std::size_t rejected = parseSheets(buffer, stem, records);
+  if(rejected > 0) std::cout << path << ": skipped " << rejected << " malformed sheets" << std::endl;
+  return !records.empty() && store.appendAll(records);
+}
+
+// An optional sign and at most MAX_NUMBER_INPUT digits, which changeHpLogic accepts.
+bool validNumberInput(const std::string &s)
 {
-	std::string choiceS;
-	do{
-		std::system("clear");
-    printAttributesAndStats(attributesNumbers, statsNumbers);
-		print(MENU);
-		getline(std::cin, choiceS);
-	}while(!checkMenu(choiceS));
-	return charToInt(choiceS.at(0));;
+  std::size_t digits = !s.empty() && (s[0] == '+' || s[0] == '-') ? 1 : 0;
+  return s.size() > digits && s.size() - digits <= MAX_NUMBER_INPUT && s.find_first_not_of("0123456789", digits) == std::string::npos;
 }
 
-bool menuLoop(std::vector <std::pair <std::string, int> > attributesNumbers, std::vector <std::pair <std::string, int> > &statsNumbers)
+std::string signedNumber(const int i) { return (i >= 0 ? "+" : "") + std::to_string(i); }
+
+void drawSheet(terminalScreen &screen, const characterRecord &record, const int column)
 {
-	int userChoice = inputMenu(attributesNumbers, statsNumbers);
-	if(userChoice == QUIT) return 1;
-  else if(userChoice == CHANGE_HP_CODE)
+  screen.put(1, column, recordName(record));
+  for(int i = 0; i < RECORD_ATTRIBUTES; i++)
   {
-    statsNumbers[HP_POSITION].second = changeHp(statsNumbers[HP_POSITION].second);
+    screen.put(3 + i, column, std::string(SHEET_FIELDS[i]) + " " + std::to_string(record.attributes[i]) + " (" + signedNumber(attributeModifier(record.attributes[i])) + ")");
+  }
+  for(int i = 0; i < RECORD_STATS; i++)
+  {
+    screen.put(4 + RECORD_ATTRIBUTES + i, column, std::string(SHEET_FIELDS[RECORD_ATTRIBUTES + i]) + " " + std::to_string(record.stats[i]));
   }
-	return 0;
 }
 
+// Only the visible part of the list is drawn, however many characters there are.
+void drawCharacterList(terminalScreen &screen, const characterStore &store, const uint32_t current, const uint32_t top, const int listRows)
+{
+  for(int row = 0; row < listRows && top + (uint32_t)row < store.count(); row++)
+  {
+    uint32_t i = top + (uint32_t)row;
+    screen.put(1 + row, 0, (i == current ? "> " : "  ") + std::to_string(i) + " " + recordName(store.record(i)));
+  }
+}
 
-int main()
+// Accepts a character number or name, keeps the current one otherwise.
+uint32_t goToCharacter(const characterStore &store, const std::string &answer, const uint32_t current)
 {
-  std::ifstream InputstatsFile ("stats.txt");
+  if(validNumberInput(answer) && answer[0] != '-' && answer[0] != '+' && std::stoul(answer) < store.count()) return (uint32_t)std::stoul(answer);
+  uint32_t found = store.find(answer);
+  return found < store.count() ? found : current;
+}
 
-  std::vector <std::string> stats = fileToVector(InputstatsFile);
-  InputstatsFile.close();
-  std::vector <std::pair <std::string, int> > attributesNumbers = stringToAttributes(stats);
-  std::vector <std::pair <std::string, int> > statsNumbers = stringToStats(stats);
+void runInterface(characterStore &store, uint32_t current)
+{
+  terminalScreen screen;
+  uint32_t top = 0;
+  std::string status;
+  std::string answer;
+  while(true)
+  {
+    const int listRows = screen.rows() > 4 ? screen.rows() - 3 : 1;
+    const int statusRow = screen.rows() - 1;
+    if(current < top) top = current;
+    if(current >= top + (uint32_t)listRows) top = current - (uint32_t)listRows + 1;
+    screen.clear();
+    screen.put(0, 0, "dungeonWorld, " + std::to_string(store.count()) + " characters");
+    drawCharacterList(screen, store, current, top, listRows);
+    drawSheet(screen, store.record(current), LIST_WIDTH);
+    screen.put(statusRow - 1, 0, MENU);
+    screen.put(statusRow, 0, status);
+    screen.present();
+    status.clear();
+    int key = screen.readKey();
+    if(key == KEY_END_OF_INPUT || key == KEY_INTERRUPT || key == 'q' || key == '0' + QUIT) return;
+    if((key == KEY_UP || key == 'k') && current > 0) current--;
+    else if((key == KEY_DOWN || key == 'j') && current + 1 < store.count()) current++;
+    else if(key == KEY_PAGE_UP) current = current > (uint32_t)listRows ? current - (uint32_t)listRows : 0;
+    else if(key == KEY_PAGE_DOWN) current = current + (uint32_t)listRows < store.count() ? current + (uint32_t)listRows : store.count() - 1;
+    else if(key == '0' + CHANGE_HP_CODE && screen.prompt(statusRow, "HP change ('+' for positive, '' or '-' for negative): ", answer))
+    {
+      if(!validNumberInput(answer)) status = "Not a number: " + answer;
+      else store.changeHp(current, changeHpLogic(answer));
+    }else if(key == '0' + SWITCH_CHARACTER_CODE && screen.prompt(statusRow, "Character number or name: ", answer)) current = goToCharacter(store, answer, current);
+    else if(key == '0' + GAIN_XP_CODE && screen.prompt(statusRow, "XP gained: ", answer))
+    {
+      if(!validNumberInput(answer)) status = "Not a number: " + answer;
+      else store.gainXp(current, std::stoi(answer));
+    }else if(key == '0' + LEVEL_UP_CODE && !store.levelUp(current)) status = "Not enough XP for the next level";
+  }
+}
 
-  bool end = 0;
-	while(!end) { end = menuLoop(attributesNumbers, statsNumbers); };
+void printFightUsage()
+{
+  print("Usage: dungeonWorld fight <monster hp> <monster armor> <monster damage> [character damage] [fights] [threads]");
+  print("Monster HP must be positive; damage is a dice expression such as 1d10 or 2d6+1");
+  print("Threads must be positive and are capped at the number of cores");
+}
 
+// Every character in the store against the same monster.
+int fightCommand(const characterStore &store, const int argc, char **argv)
+{
+  encounter setup;
+  uint64_t fights = DEFAULT_FIGHTS;
+  unsigned int threads = std::thread::hardware_concurrency();
+  if(argc < 5 || !parseValue(argv[2], setup.monsterHp) || setup.monsterHp <= 0 || !parseValue(argv[3], setup.monsterArmor)
+  || !parseDice(argv[4], setup.monsterDamage) || (argc > 5 && !parseDice(argv[5], setup.heroDamage))
+  || (argc > 6 && (!parseValue(argv[6], fights) || fights == 0)) || (argc > 7 && (!parseValue(argv[7], threads) || threads == 0)))
+  {
+    printFightUsage();
+    return 1;
+  }
+  uint64_t seed = ((uint64_t)std::random_device{}() << 32) ^ std::random_device{}();
+  std::cout << "Monster: " << setup.monsterHp << " HP, " << setup.monsterArmor << " armor, " << diceToString(setup.monsterDamage)
+  << " damage; characters deal " << diceToString(setup.heroDamage) << ", " << fights << " fights each" << std::endl;
+  auto start = std::chrono::steady_clock::now();
+  for(uint32_t i = 0; i < store.count(); i++) printOutcomes(recordName(store.record(i)), simulateFights(store.record(i), setup, fights, threads, seed + i));
+  double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+  std::cout << std::setprecision(0) << (double)fights * store.count() / seconds << " fights/s" << std::endl;
+  return 0;
+}
 
-  std::vector <std::pair <std::string, int> > v = attributesAndStatsTogether(attributesNumbers, statsNumbers);
-  std::vector <std::string> newStats = pairToStringVector(v);
-  std::ofstream OutputstatsFile ("stats.txt");
-  vectorToFile(newStats, OutputstatsFile);
-  OutputstatsFile.close();
+void printOddsUsage()
+{
+  print("Usage: dungeonWorld odds <dice> <target> [attribute]");
+  print("Chance of rolling target or more, e.g. odds 2d6 10 WIS for every character");
+}
+
+int oddsCommand(const characterStore &store, const int argc, char **argv)
+{
+  dice roll;
+  int target;
+  if(argc < 4 || !parseDice(argv[2], roll) || !parseValue(argv[3], target))
+  {
+    printOddsUsage();
+    return 1;
+  }
+  diceOdds odds;
+  std::cout << std::fixed << std::setprecision(4);
+  if(argc < 5)
+  {
+    std::cout << "P(" << target << "+ on " << diceToString(roll) << ") = " << odds.chanceAtLeast(roll, target) << std::endl;
+    return 0;
+  }
+  int attribute = sheetField(argv[4]);
+  if(attribute < 0 || attribute >= RECORD_ATTRIBUTES)
+  {
+    printOddsUsage();
+    return 1;
+  }
+  dice base = roll;
+  for(uint32_t i = 0; i < store.count(); i++)
+  {
+    roll.modifier = base.modifier + attributeModifier(store.record(i).attributes[attribute]);
+    std::cout << recordName(store.record(i)) << ": P(" << target << "+ on " << diceToString(base) << "+" << argv[4]
+    << ") = " << odds.chanceAtLeast(roll, target) << std::endl;
+  }
+  return 0;
+}
+
+std::string formatTime(const int64_t seconds)
+{
+  std::time_t time = (std::time_t)seconds;
+  char text[32];
+  std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", std::localtime(&time));
+  return text;
+}
+
+// Every event, or only those of the named character.
+int historyCommand(const characterStore &store, const int argc, char **argv)
+{
+  uint32_t only = argc > 2 ? store.find(argv[2]) : store.count();
+  if(argc > 2 && only == store.count())
+  {
+    print("No character named " + std::string(argv[2]));
+    return 1;
+  }
+  store.forEachEvent([&](const characterEvent &event, const characterRecord &)
+  {
+    if(argc > 2 && event.character != only) return;
+    std::cout << "#" << event.sequence << " " << formatTime(event.time) << " " << recordName(store.record(event.character)) << ": " << eventDescription(event) << std::endl;
+  });
+  return 0;
+}
+
+// Every character as it was right after the given event.
+int atCommand(const characterStore &store, const int argc, char **argv)
+{
+  uint32_t sequence;
+  if(argc < 3 || !parseValue(argv[2], sequence))
+  {
+    print("Usage: dungeonWorld at <event number>, see dungeonWorld history");
+    return 1;
+  }
+  if(sequence > store.lastEvent())
+  {
+    print("There is no event #" + std::to_string(sequence) + ", the last one is #" + std::to_string(store.lastEvent()));
+    return 1;
+  }
+  std::vector <characterRecord> state;
+  if(!store.reconstruct(sequence, state))
+  {
+    print("Could not read the snapshots");
+    return 1;
+  }
+  for(std::size_t i = 0; i < state.size(); i++)
+  {
+    std::cout << recordName(state[i]);
+    for(int s = 0; s < RECORD_STATS; s++) std::cout << " " << SHEET_FIELDS[RECORD_ATTRIBUTES + s] << " " << state[i].stats[s];
+    std::cout << std::endl;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  characterStore store;
+  if(!store.open(STORE_FILE, LOG_FILE, SNAPSHOT_FILE))
+  {
+    print("Could not open " + STORE_FILE);
+    return 1;
+  }
+  if(argc > 1 && argv[1] == IMPORT_COMMAND)
+  {
+    auto start = std::chrono::steady_clock::now();
+    uint32_t before = store.count();
+    for(int i = 2; i < argc; i++) if(!importSheets(store, argv[i])) std::cout << "Nothing imported from " << argv[i] << std::endl;
+    double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+    std::cout << "Imported " << store.count() - before << " characters in " << seconds << " s" << std::endl;
+    return 0;
+  }
+  if(argc > 1 && argv[1] == FIGHT_COMMAND) return fightCommand(store, argc, argv);
+  if(argc > 1 && argv[1] == ODDS_COMMAND) return oddsCommand(store, argc, argv);
+  if(argc > 1 && argv[1] == HISTORY_COMMAND) return historyCommand(store, argc, argv);
+  if(argc > 1 && argv[1] == AT_COMMAND) return atCommand(store, argc, argv);
+  if(store.count() == 0 && !importSheets(store, STATS_FILE))
+  {
+    print("No characters yet and no " + STATS_FILE + " to import");
+    return 1;
+  }
+  uint32_t current = 0;
+  if(argc > 1 && store.find(argv[1]) < store.count()) current = store.find(argv[1]);
 
+  runInterface(store, current);
 
   return 0;
 }
@@ -0,0 +1,135 @@
+#ifndef SHEET_PARSER_CPP
+#define SHEET_PARSER_CPP
+
+// Character sheets in text form: one "FIELD value" line per attribute and
+// stat, in any order, and an optional "NAME character" line. One file may
+// hold many sheets separated by blank lines. The whole file is read into a
+// single buffer and parsed through string_views with std::from_chars, so
+// nothing is allocated per line.
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "characterStore.cpp"
+
+const int SHEET_FIELD_COUNT = RECORD_ATTRIBUTES + RECORD_STATS;
+const std::string_view SHEET_NAME_FIELD = "NAME";
+// Record order: the attributes, then the stats.
+const std::string_view SHEET_FIELDS[SHEET_FIELD_COUNT] = {"STR", "DEX", "CON", "INT", "WIS", "CHA", "HP", "ARMOR", "LVL", "XP", "XPNEEDED"};
+const uint32_t ALL_SHEET_FIELDS = (1u << SHEET_FIELD_COUNT) - 1;
+
+bool readWholeFile(const std::string &path, std::string &buffer)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0) return false;
+  struct stat status;
+  if(fstat(fd, &status) != 0)
+  {
+    close(fd);
+    return false;
+  }
+  buffer.resize((std::size_t)status.st_size);
+  std::size_t done = 0;
+  while(done < buffer.size())
+  {
+    ssize_t got = read(fd, buffer.data() + done, buffer.size() - done);
+    if(got <= 0) break;
+    done += (std::size_t)got;
+  }
+  close(fd);
+  buffer.resize(done);
+  return true;
+}
+
+// Cuts the first line off text, without its '\n' or a trailing '\r'.
+std::string_view nextLine(std::string_view &text)
+{
+  std::size_t end = text.find('\n');
+  std::string_view line = text.substr(0, end);
+  text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+  if(!line.empty() && line.back() == '\r') line.remove_suffix(1);
+  return line;
+}
+
+int sheetField(const std::string_view key)
+{
+  for(int i = 0; i < SHEET_FIELD_COUNT; i++) if(SHEET_FIELDS[i] == key) return i;
+  return -1;
+}
+
+template <typename number>
+bool parseValue(const std::string_view text, number &value)
+{
+  std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+  return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// Parses the sheet at the start of text and consumes it along with the
+// blank line ending it. A sheet missing a field, repeating one or holding
+// an unknown one is rejected. named tells whether it had a NAME line.
+bool parseSheet(std::string_view &text, characterRecord &record, bool &named)
+{
+  std::memset(&record, 0, sizeof(record));
+  named = false;
+  uint32_t seen = 0;
+  bool valid = true;
+  while(!text.empty())
+  {
+    std::string_view line = nextLine(text);
+    if(line.empty()) break;
+    std::size_t separator = line.find(' ');
+    if(separator == std::string_view::npos)
+    {
+      valid = false;
+      continue;
+    }
+    std::string_view key = line.substr(0, separator);
+    std::string_view value = line.substr(separator + 1);
+    if(key == SHEET_NAME_FIELD)
+    {
+      setRecordName(record, value);
+      named = true;
+      continue;
+    }
+    int field = sheetField(key);
+    if(field < 0 || (seen >> field) & 1)
+    {
+      valid = false;
+      continue;
+    }
+    int32_t *slot = field < RECORD_ATTRIBUTES ? &record.attributes[field] : &record.stats[field - RECORD_ATTRIBUTES];
+    if(!parseValue(value, *slot)) valid = false;
+    seen |= 1u << field;
+  }
+  return valid && seen == ALL_SHEET_FIELDS;
+}
+
+// Appends every valid sheet in text to records and returns how many sheets
+// were rejected. Unnamed sheets are called defaultName, defaultName-2, ...
+std::size_t parseSheets(std::string_view text, const std::string &defaultName, std::vector <characterRecord> &records)
+{
+  std::size_t rejected = 0;
+  std::size_t unnamed = 0;
+  while(!text.empty())
+  {
+    while(!text.empty() && (text.front() == '\n' || text.front() == '\r')) text.remove_prefix(1);
+    if(text.empty()) break;
+    characterRecord record;
+    bool named;
+    if(!parseSheet(text, record, named))
+    {
+      rejected++;
+      continue;
+    }
+    if(!named) setRecordName(record, ++unnamed == 1 ? defaultName : defaultName + "-" + std::to_string(unnamed));
+    records.push_back(record);
+  }
+  return rejected;
+}
+
+#endif
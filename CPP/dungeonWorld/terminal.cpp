@@ -0,0 +1,203 @@
+#ifndef TERMINAL_CPP
+#define TERMINAL_CPP
+
+// A full-screen terminal without curses. Lines are drawn into a back buffer
+// and present() sends only the lines that differ from what is already on
+// screen, with ANSI escapes, in a single write. Input is read one key at a
+// time with the terminal in raw mode. When stdin is not a terminal (piped
+// input) keys are still read byte by byte, only the mode is left alone.
+// Raw mode also turns off the signal keys, so Ctrl-C arrives as
+// KEY_INTERRUPT. SIGTERM and SIGHUP put the terminal back before exiting.
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <csignal>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+const int KEY_END_OF_INPUT = -1;
+const int KEY_INTERRUPT = 3;
+const int KEY_BACKSPACE = 127;
+const int KEY_ESCAPE = 27;
+const int KEY_ENTER = '\n';
+const int KEY_UP = 1000;
+const int KEY_DOWN = 1001;
+const int KEY_PAGE_UP = 1002;
+const int KEY_PAGE_DOWN = 1003;
+
+const int DEFAULT_ROWS = 24;
+const int DEFAULT_COLUMNS = 80;
+// How long to wait for the rest of an escape sequence before taking a lone Escape.
+const int ESCAPE_WAIT_MS = 25;
+
+const char ENTER_SCREEN[] = "\x1b[?1049h\x1b[?25l\x1b[2J";
+const char LEAVE_SCREEN[] = "\x1b[?25h\x1b[?1049l";
+
+// What the signal handler needs to put the terminal back.
+termios restoreState;
+bool restoreRawMode = false;
+
+// Only async-signal-safe calls: write, tcsetattr and _exit.
+void restoreTerminalAndExit(const int signal)
+{
+  if(write(STDOUT_FILENO, LEAVE_SCREEN, sizeof(LEAVE_SCREEN) - 1) < 0) {}
+  if(restoreRawMode) tcsetattr(STDIN_FILENO, TCSAFLUSH, &restoreState);
+  _exit(128 + signal);
+}
+
+class terminalScreen
+{
+  public:
+  terminalScreen()
+  {
+    rawMode = isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved) == 0;
+    if(rawMode)
+    {
+      termios raw = saved;
+      raw.c_lflag &= ~(tcflag_t)(ICANON | ECHO | ISIG);
+      raw.c_cc[VMIN] = 1;
+      raw.c_cc[VTIME] = 0;
+      tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+    }
+    restoreState = saved;
+    restoreRawMode = rawMode;
+    std::signal(SIGTERM, restoreTerminalAndExit);
+    std::signal(SIGHUP, restoreTerminalAndExit);
+    // Alternate screen, so the shell's scrollback is left as it was.
+    send(ENTER_SCREEN);
+    resize();
+    clear();
+  }
+
+  terminalScreen(const terminalScreen &) = delete;
+  terminalScreen &operator=(const terminalScreen &) = delete;
+
+  ~terminalScreen()
+  {
+    std::signal(SIGTERM, SIG_DFL);
+    std::signal(SIGHUP, SIG_DFL);
+    send(LEAVE_SCREEN);
+    if(rawMode) tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved);
+  }
+
+  int rows() const { return height; }
+  int columns() const { return width; }
+
+  void clear() { back.assign((std::size_t)height, std::string()); }
+
+  // Writes text into the back buffer, cut off at the right edge.
+  void put(const int row, const int column, const std::string_view text)
+  {
+    if(row < 0 || row >= height || column >= width) return;
+    std::string &line = back[(std::size_t)row];
+    std::size_t start = (std::size_t)column;
+    std::size_t length = text.size() < (std::size_t)width - start ? text.size() : (std::size_t)width - start;
+    if(line.size() < start + length) line.resize(start + length, ' ');
+    line.replace(start, length, text.substr(0, length));
+  }
+
+  // Sends the changed lines; a cursor row of -1 keeps the cursor hidden.
+  void present(const int cursorRow = -1, const int cursorColumn = 0)
+  {
+    std::string out;
+    if(resize())
+    {
+      front.clear();
+      out += "\x1b[2J";
+      back.resize((std::size_t)height);
+    }
+    for(std::size_t row = 0; row < back.size(); row++)
+    {
+      if(row < front.size() && front[row] == back[row]) continue;
+      out += "\x1b[" + std::to_string(row + 1) + ";1H" + back[row] + "\x1b[K";
+    }
+    if(cursorRow >= 0) out += "\x1b[" + std::to_string(cursorRow + 1) + ";" + std::to_string(cursorColumn + 1) + "H\x1b[?25h";
+    else out += "\x1b[?25l";
+    send(out);
+    front = back;
+  }
+
+  int readKey() const
+  {
+    unsigned char c;
+    if(read(STDIN_FILENO, &c, 1) != 1) return KEY_END_OF_INPUT;
+    if(c == '\r') return KEY_ENTER;
+    if(c == '\b') return KEY_BACKSPACE;
+    if(c != KEY_ESCAPE || !inputWaiting()) return c;
+    unsigned char sequence[3] = {0, 0, 0};
+    if(read(STDIN_FILENO, &sequence[0], 1) != 1 || sequence[0] != '[' || !inputWaiting()) return KEY_ESCAPE;
+    if(read(STDIN_FILENO, &sequence[1], 1) != 1) return KEY_ESCAPE;
+    if(sequence[1] == 'A') return KEY_UP;
+    if(sequence[1] == 'B') return KEY_DOWN;
+    if((sequence[1] == '5' || sequence[1] == '6') && inputWaiting() && read(STDIN_FILENO, &sequence[2], 1) == 1 && sequence[2] == '~')
+    {
+      return sequence[1] == '5' ? KEY_PAGE_UP : KEY_PAGE_DOWN;
+    }
+    return KEY_ESCAPE;
+  }
+
+  // Reads a line on the given row after the prompt, redrawing only that
+  // row. Escape, Ctrl-C or the end of input gives up and returns false.
+  bool prompt(const int row, const std::string &question, std::string &answer)
+  {
+    answer.clear();
+    while(true)
+    {
+      if(row < height) back[(std::size_t)row].clear();
+      put(row, 0, question + answer);
+      present(row, (int)(question.size() + answer.size()));
+      int key = readKey();
+      if(key == KEY_ENTER) return true;
+      if(key == KEY_ESCAPE || key == KEY_INTERRUPT || key == KEY_END_OF_INPUT) return false;
+      if(key == KEY_BACKSPACE && !answer.empty()) answer.pop_back();
+      else if(key >= ' ' && key < KEY_BACKSPACE) answer += (char)key;
+    }
+  }
+
+  private:
+  bool rawMode = false;
+  termios saved;
+  int height = DEFAULT_ROWS;
+  int width = DEFAULT_COLUMNS;
+  std::vector <std::string> back;
+  std::vector <std::string> front;
+
+  static void send(const std::string &out)
+  {
+    std::size_t done = 0;
+    while(done < out.size())
+    {
+      ssize_t written = write(STDOUT_FILENO, out.data() + done, out.size() - done);
+      if(written <= 0) return;
+      done += (std::size_t)written;
+    }
+  }
+
+  static bool inputWaiting()
+  {
+    pollfd input = {STDIN_FILENO, POLLIN, 0};
+    return poll(&input, 1, ESCAPE_WAIT_MS) > 0;
+  }
+
+  // Returns true when the size changed.
+  bool resize()
+  {
+    winsize size;
+    int newHeight = DEFAULT_ROWS;
+    int newWidth = DEFAULT_COLUMNS;
+    if(ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0 && size.ws_col > 0)
+    {
+      newHeight = size.ws_row;
+      newWidth = size.ws_col;
+    }
+    bool changed = newHeight != height || newWidth != width;
+    height = newHeight;
+    width = newWidth;
+    return changed;
+  }
+};
+
+#endif
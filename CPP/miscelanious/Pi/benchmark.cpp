@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include "bigInteger.cpp"
+
+// Times one top-level step of each multiplication algorithm on balanced
+// random operands, checks that they agree, and prints the sizes at which the
+// fastest one changes. Those crossovers are what the thresholds in
+// bigInteger.cpp should be set to. The smaller products inside each step use
+// the current thresholds, so it is worth running again after changing them.
+
+const std::size_t FIRST_SIZE = 8;
+const std::size_t LAST_SIZE = 1 << 16;
+// Sizes grow by this factor, so a crossover is found within about 20%.
+const double SIZE_STEP = 1.2;
+// Each timing repeats until it has run for at least this long.
+const double MINIMUM_SECONDS = 0.05;
+// Schoolbook is quadratic; past this size it only slows the benchmark down.
+const std::size_t SCHOOLBOOK_LIMIT = 1 << 12;
+
+const multiplyAlgorithm ALGORITHMS[] = {MULTIPLY_SCHOOLBOOK, MULTIPLY_KARATSUBA, MULTIPLY_TOOM3, MULTIPLY_NTT};
+const char *const ALGORITHM_NAMES[] = {"schoolbook", "karatsuba", "toom3", "ntt"};
+const std::size_t ALGORITHM_COUNT = 4;
+
+limbVector randomLimbs(std::mt19937_64 &random, const std::size_t size)
+{
+	std::uniform_int_distribution <uint32_t> limb(0, BIG_BASE - 1);
+	limbVector limbs(size);
+	for(std::size_t i = 0; i < size; i++) limbs[i] = limb(random);
+	if(limbs.back() == 0) limbs.back() = 1;
+	return limbs;
+}
+
+// Seconds per multiplication, or a negative number when the product differs
+// from `expected`. An empty `expected` is set to the product instead.
+double timeMultiply(const multiplyAlgorithm algorithm, const limbVector &a, const limbVector &b, limbVector &expected)
+{
+	std::size_t runs = 0;
+	double seconds = 0;
+	auto start = std::chrono::steady_clock::now();
+	while(seconds < MINIMUM_SECONDS)
+	{
+		limbVector product = multiplyWith(algorithm, a.data(), a.size(), b.data(), b.size());
+		if(runs == 0 && expected.empty()) expected = product;
+		else if(runs == 0 && product != expected) return -1;
+		runs++;
+		seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+	}
+	return seconds / (double)runs;
+}
+
+int main()
+{
+	std::mt19937_64 random(2024);
+	std::string crossovers;
+	std::size_t fastest = ALGORITHM_COUNT;
+	std::cout << std::setw(8) << "limbs";
+	for(std::size_t i = 0; i < ALGORITHM_COUNT; i++) std::cout << std::setw(14) << ALGORITHM_NAMES[i];
+	std::cout << std::setw(12) << "fastest" << "   (microseconds per product)" << std::endl;
+	for(double step = FIRST_SIZE; step <= LAST_SIZE; step *= SIZE_STEP)
+	{
+		const std::size_t size = (std::size_t)step;
+		limbVector a = randomLimbs(random, size);
+		limbVector b = randomLimbs(random, size);
+		// Each algorithm is checked against the first one that ran.
+		limbVector expected;
+		double times[ALGORITHM_COUNT];
+		std::cout << std::setw(8) << size;
+		for(std::size_t i = 0; i < ALGORITHM_COUNT; i++)
+		{
+			times[i] = ALGORITHMS[i] == MULTIPLY_SCHOOLBOOK && size > SCHOOLBOOK_LIMIT ? 0 : timeMultiply(ALGORITHMS[i], a, b, expected);
+			if(times[i] < 0)
+			{
+				std::cout << std::endl << ALGORITHM_NAMES[i] << " gave a wrong product at " << size << " limbs" << std::endl;
+				return 1;
+			}
+			if(times[i] == 0) std::cout << std::setw(14) << "-";
+			else std::cout << std::setw(14) << std::fixed << std::setprecision(1) << times[i] * 1e6;
+		}
+		std::size_t best = 0;
+		for(std::size_t i = 1; i < ALGORITHM_COUNT; i++)
+		{
+			if(times[i] != 0 && (times[best] == 0 || times[i] < times[best])) best = i;
+		}
+		std::cout << std::setw(12) << ALGORITHM_NAMES[best] << std::endl;
+		if(best != fastest) crossovers += std::string(ALGORITHM_NAMES[best]) + " from " + std::to_string(size) + " limbs (" + std::to_string(size * BIG_BASE_DIGITS) + " digits)\n";
+		fastest = best;
+	}
+	std::cout << std::endl << "Crossovers:" << std::endl << crossovers;
+	return 0;
+}
@@ -0,0 +1,149 @@
+#ifndef BIG_FLOAT_CPP
+#define BIG_FLOAT_CPP
+
+// Floating point on top of bigInteger: mantissa * BIG_BASE^exponent.
+// Precision is counted in limbs and passed to every operation that rounds.
+// There is no division; it is a reciprocal from Newton's method followed by
+// a multiplication. Square roots go through the inverse square root the
+// same way. Both iterations double the number of correct limbs each step,
+// so they start from a long double guess and double the working precision
+// as they go, doing the full-precision work only once.
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include "bigInteger.cpp"
+
+// Limbs kept beyond the requested precision while iterating.
+const std::size_t GUARD_LIMBS = 2;
+// 1/2 is this many BIG_BASE^-1.
+const uint32_t HALF_BIG_BASE = BIG_BASE / 2;
+
+struct bigFloat
+{
+	bigInteger mantissa;
+	long long exponent = 0;
+
+	bigFloat() {}
+	bigFloat(const bigInteger &value, const long long power = 0) : mantissa(value), exponent(power) {}
+};
+
+// Drops low limbs beyond the given precision, rounding towards zero.
+bigFloat truncateTo(const bigFloat &a, const std::size_t limbs)
+{
+	if(a.mantissa.limbs.size() <= limbs) return a;
+	std::size_t dropped = a.mantissa.limbs.size() - limbs;
+	return bigFloat(shiftLimbsDown(a.mantissa, dropped), a.exponent + (long long)dropped);
+}
+
+bigFloat multiply(const bigFloat &a, const bigFloat &b, const std::size_t limbs)
+{
+	return truncateTo(bigFloat(a.mantissa * b.mantissa, a.exponent + b.exponent), limbs);
+}
+
+// Exact: the operand with the higher exponent is shifted down to the other.
+bigFloat add(const bigFloat &a, const bigFloat &b)
+{
+	if(a.mantissa.isZero()) return b;
+	if(b.mantissa.isZero()) return a;
+	if(a.exponent < b.exponent) return bigFloat(a.mantissa + shiftLimbsUp(b.mantissa, (std::size_t)(b.exponent - a.exponent)), a.exponent);
+	return bigFloat(shiftLimbsUp(a.mantissa, (std::size_t)(a.exponent - b.exponent)) + b.mantissa, b.exponent);
+}
+
+bigFloat subtract(const bigFloat &a, const bigFloat &b) { return add(a, bigFloat(-b.mantissa, b.exponent)); }
+
+// The top limbs of a positive number as a long double m, a = m * BIG_BASE^power.
+long double leadingValue(const bigFloat &a, long long &power)
+{
+	const limbVector &limbs = a.mantissa.limbs;
+	std::size_t used = limbs.size() < 3 ? limbs.size() : 3;
+	long double value = 0;
+	for(std::size_t i = 0; i < used; i++) value = value * BIG_BASE + limbs[limbs.size() - 1 - i];
+	power = a.exponent + (long long)(limbs.size() - used);
+	return value;
+}
+
+// A long double written as a two-limb bigFloat times BIG_BASE^power.
+bigFloat fromLongDouble(const long double value, const long long power)
+{
+	long double scaled = value;
+	long long exponent = power;
+	while(scaled < (long double)BIG_BASE * BIG_BASE)
+	{
+		scaled *= BIG_BASE;
+		exponent--;
+	}
+	while(scaled >= (long double)BIG_BASE * BIG_BASE * BIG_BASE)
+	{
+		scaled /= BIG_BASE;
+		exponent++;
+	}
+	return bigFloat(bigInteger((long long)(scaled / BIG_BASE)), exponent + 1);
+}
+
+// 1 / a for positive a: x += x (1 - a x).
+bigFloat reciprocal(const bigFloat &a, const std::size_t limbs)
+{
+	long long power;
+	long double leading = leadingValue(a, power);
+	bigFloat x = fromLongDouble(1.0L / leading, -power);
+	const bigFloat one(bigInteger(1));
+	std::size_t precision = 1;
+	while(precision < limbs + GUARD_LIMBS)
+	{
+		precision = 2 * precision < limbs + GUARD_LIMBS ? 2 * precision : limbs + GUARD_LIMBS;
+		bigFloat error = subtract(one, multiply(truncateTo(a, precision + GUARD_LIMBS), x, 2 * precision + GUARD_LIMBS));
+		x = truncateTo(add(x, multiply(x, error, precision + GUARD_LIMBS)), precision + GUARD_LIMBS);
+	}
+	return truncateTo(x, limbs);
+}
+
+// 1 / sqrt(a) for positive a: y += y (1 - a y^2) / 2.
+bigFloat inverseSquareRoot(const bigFloat &a, const std::size_t limbs)
+{
+	long long power;
+	long double leading = leadingValue(a, power);
+	// Keeps the guess exact for odd powers of BIG_BASE.
+	if(power % 2 != 0)
+	{
+		leading *= BIG_BASE;
+		power--;
+	}
+	bigFloat y = fromLongDouble(1.0L / std::sqrt(leading), -power / 2);
+	const bigFloat one(bigInteger(1));
+	const bigFloat half(bigInteger(HALF_BIG_BASE), -1);
+	std::size_t precision = 1;
+	while(precision < limbs + GUARD_LIMBS)
+	{
+		precision = 2 * precision < limbs + GUARD_LIMBS ? 2 * precision : limbs + GUARD_LIMBS;
+		bigFloat square = multiply(y, y, 2 * precision + GUARD_LIMBS);
+		bigFloat error = subtract(one, multiply(truncateTo(a, precision + GUARD_LIMBS), square, 2 * precision + GUARD_LIMBS));
+		bigFloat step = multiply(multiply(y, error, precision + GUARD_LIMBS), half, precision + GUARD_LIMBS);
+		y = truncateTo(add(y, step), precision + GUARD_LIMBS);
+	}
+	return truncateTo(y, limbs);
+}
+
+// The integer part, a point and then exactly `digits` decimals, cut off.
+std::string toDecimal(const bigFloat &a, const std::size_t digits)
+{
+	std::string text = a.mantissa.toString();
+	bool negative = !text.empty() && text[0] == '-';
+	if(negative) text.erase(0, 1);
+	std::string integerPart;
+	std::string fraction;
+	if(a.exponent >= 0)
+	{
+		integerPart = text + std::string((std::size_t)a.exponent * BIG_BASE_DIGITS, '0');
+	}else
+	{
+		std::size_t fractionDigits = (std::size_t)(-a.exponent) * BIG_BASE_DIGITS;
+		if(text.size() <= fractionDigits) text.insert(0, fractionDigits - text.size() + 1, '0');
+		integerPart = text.substr(0, text.size() - fractionDigits);
+		fraction = text.substr(text.size() - fractionDigits);
+	}
+	fraction.resize(digits, '0');
+	return (negative ? "-" : "") + integerPart + (digits > 0 ? "." + fraction : "");
+}
+
+#endif
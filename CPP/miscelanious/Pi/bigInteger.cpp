@@ -0,0 +1,338 @@
+#ifndef BIG_INTEGER_CPP
+#define BIG_INTEGER_CPP
+
+// Signed integers of any size. The magnitude is a vector of limbs in base
+// 10^9, least significant first and without leading zero limbs, so zero is
+// the empty vector and printing in decimal needs no division.
+// Multiplication picks its algorithm by the size of the shorter operand:
+// schoolbook, Karatsuba, Toom-3 and then number-theoretic transforms. The
+// thresholds come from `make benchmark`, which prints the crossovers.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "numberTheoreticTransform.cpp"
+
+typedef std::vector <uint32_t> limbVector;
+
+const uint32_t BIG_BASE = 1000000000;
+const int BIG_BASE_DIGITS = 9;
+// Limbs in the shorter operand from which each algorithm beats the one before.
+const std::size_t KARATSUBA_THRESHOLD = 28;
+const std::size_t TOOM3_THRESHOLD = 200;
+const std::size_t NTT_THRESHOLD = 750;
+
+enum multiplyAlgorithm
+{
+	MULTIPLY_AUTO,
+	MULTIPLY_SCHOOLBOOK,
+	MULTIPLY_KARATSUBA,
+	MULTIPLY_TOOM3,
+	MULTIPLY_NTT
+};
+
+void trimLimbs(limbVector &limbs)
+{
+	while(!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+}
+
+int compareLimbs(const limbVector &a, const limbVector &b)
+{
+	if(a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+	for(std::size_t i = a.size(); i > 0; i--)
+	{
+		if(a[i - 1] != b[i - 1]) return a[i - 1] < b[i - 1] ? -1 : 1;
+	}
+	return 0;
+}
+
+// result += b * BIG_BASE^offset, result growing as needed.
+void addLimbsAt(limbVector &result, const uint32_t *b, const std::size_t nb, const std::size_t offset)
+{
+	if(result.size() < offset + nb + 1) result.resize(offset + nb + 1, 0);
+	uint32_t carry = 0;
+	std::size_t i = 0;
+	for(; i < nb || carry != 0; i++)
+	{
+		if(offset + i == result.size()) result.push_back(0);
+		uint32_t sum = result[offset + i] + (i < nb ? b[i] : 0) + carry;
+		carry = sum >= BIG_BASE;
+		result[offset + i] = carry ? sum - BIG_BASE : sum;
+	}
+}
+
+// a -= b, with a >= b.
+void subtractLimbs(limbVector &a, const limbVector &b)
+{
+	uint32_t borrow = 0;
+	for(std::size_t i = 0; i < a.size() && (i < b.size() || borrow != 0); i++)
+	{
+		uint32_t subtrahend = (i < b.size() ? b[i] : 0) + borrow;
+		borrow = a[i] < subtrahend;
+		a[i] = borrow ? a[i] + BIG_BASE - subtrahend : a[i] - subtrahend;
+	}
+	trimLimbs(a);
+}
+
+limbVector schoolbookMultiply(const uint32_t *a, const std::size_t na, const uint32_t *b, const std::size_t nb)
+{
+	limbVector result(na + nb, 0);
+	for(std::size_t i = 0; i < na; i++)
+	{
+		uint64_t carry = 0;
+		for(std::size_t j = 0; j < nb; j++)
+		{
+			uint64_t current = result[i + j] + (uint64_t)a[i] * b[j] + carry;
+			result[i + j] = (uint32_t)(current % BIG_BASE);
+			carry = current / BIG_BASE;
+		}
+		result[i + nb] = (uint32_t)carry;
+	}
+	trimLimbs(result);
+	return result;
+}
+
+limbVector multiplyLimbs(const uint32_t *a, std::size_t na, const uint32_t *b, std::size_t nb);
+
+// The longer operand cut into pieces of the shorter one's size, for
+// operands too lopsided to split at a common point.
+limbVector chunkedMultiply(const uint32_t *a, const std::size_t na, const uint32_t *b, const std::size_t nb)
+{
+	const uint32_t *shortOne = na < nb ? a : b;
+	const uint32_t *longOne = na < nb ? b : a;
+	const std::size_t shortSize = na < nb ? na : nb;
+	const std::size_t longSize = na < nb ? nb : na;
+	limbVector result;
+	for(std::size_t start = 0; start < longSize; start += shortSize)
+	{
+		std::size_t piece = longSize - start < shortSize ? longSize - start : shortSize;
+		limbVector product = multiplyLimbs(shortOne, shortSize, longOne + start, piece);
+		addLimbsAt(result, product.data(), product.size(), start);
+	}
+	trimLimbs(result);
+	return result;
+}
+
+// Splits both operands at half the longer one:
+// (a1 x + a0)(b1 x + b0) = a1 b1 x^2 + ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) x + a0 b0.
+limbVector karatsubaMultiply(const uint32_t *a, const std::size_t na, const uint32_t *b, const std::size_t nb)
+{
+	const std::size_t half = (na > nb ? na : nb) / 2;
+	if(na <= half || nb <= half) return chunkedMultiply(a, na, b, nb);
+	limbVector aSum(a, a + half);
+	limbVector bSum(b, b + half);
+	addLimbsAt(aSum, a + half, na - half, 0);
+	addLimbsAt(bSum, b + half, nb - half, 0);
+	trimLimbs(aSum);
+	trimLimbs(bSum);
+	limbVector low = multiplyLimbs(a, half, b, half);
+	limbVector high = multiplyLimbs(a + half, na - half, b + half, nb - half);
+	limbVector middle = multiplyLimbs(aSum.data(), aSum.size(), bSum.data(), bSum.size());
+	subtractLimbs(middle, low);
+	subtractLimbs(middle, high);
+	limbVector result = low;
+	addLimbsAt(result, middle.data(), middle.size(), half);
+	addLimbsAt(result, high.data(), high.size(), 2 * half);
+	trimLimbs(result);
+	return result;
+}
+
+struct bigInteger
+{
+	bool negative = false;
+	limbVector limbs;
+
+	bigInteger() {}
+
+	bigInteger(long long value)
+	{
+		negative = value < 0;
+		unsigned long long magnitude = negative ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+		for(; magnitude > 0; magnitude /= BIG_BASE) limbs.push_back((uint32_t)(magnitude % BIG_BASE));
+	}
+
+	bool isZero() const { return limbs.empty(); }
+
+	std::string toString() const
+	{
+		if(limbs.empty()) return "0";
+		std::string text = negative ? "-" : "";
+		text += std::to_string(limbs.back());
+		for(std::size_t i = limbs.size() - 1; i > 0; i--)
+		{
+			std::string limb = std::to_string(limbs[i - 1]);
+			text.append((std::size_t)BIG_BASE_DIGITS - limb.size(), '0');
+			text += limb;
+		}
+		return text;
+	}
+};
+
+bigInteger operator-(bigInteger a)
+{
+	a.negative = !a.negative && !a.isZero();
+	return a;
+}
+
+bigInteger operator+(const bigInteger &a, const bigInteger &b)
+{
+	bigInteger result;
+	if(a.negative == b.negative)
+	{
+		result.limbs = a.limbs;
+		addLimbsAt(result.limbs, b.limbs.data(), b.limbs.size(), 0);
+		trimLimbs(result.limbs);
+		result.negative = a.negative;
+	}else if(compareLimbs(a.limbs, b.limbs) >= 0)
+	{
+		result.limbs = a.limbs;
+		subtractLimbs(result.limbs, b.limbs);
+		result.negative = a.negative && !result.isZero();
+	}else
+	{
+		result.limbs = b.limbs;
+		subtractLimbs(result.limbs, a.limbs);
+		result.negative = b.negative;
+	}
+	return result;
+}
+
+bigInteger operator-(const bigInteger &a, const bigInteger &b) { return a + -b; }
+
+bigInteger operator*(const bigInteger &a, const bigInteger &b)
+{
+	bigInteger result;
+	result.limbs = multiplyLimbs(a.limbs.data(), a.limbs.size(), b.limbs.data(), b.limbs.size());
+	result.negative = a.negative != b.negative && !result.isZero();
+	return result;
+}
+
+bigInteger multiplySmall(const bigInteger &a, const uint32_t factor)
+{
+	bigInteger result;
+	result.negative = a.negative && factor != 0;
+	result.limbs.reserve(a.limbs.size() + 2);
+	uint64_t carry = 0;
+	for(std::size_t i = 0; i < a.limbs.size(); i++)
+	{
+		uint64_t current = (uint64_t)a.limbs[i] * factor + carry;
+		result.limbs.push_back((uint32_t)(current % BIG_BASE));
+		carry = current / BIG_BASE;
+	}
+	for(; carry > 0; carry /= BIG_BASE) result.limbs.push_back((uint32_t)(carry % BIG_BASE));
+	trimLimbs(result.limbs);
+	return result;
+}
+
+// a * BIG_BASE^count
+bigInteger shiftLimbsUp(const bigInteger &a, const std::size_t count)
+{
+	bigInteger result = a;
+	if(!result.isZero()) result.limbs.insert(result.limbs.begin(), count, 0);
+	return result;
+}
+
+// The magnitude divided by BIG_BASE^count, rounded towards zero.
+bigInteger shiftLimbsDown(const bigInteger &a, const std::size_t count)
+{
+	bigInteger result;
+	if(count >= a.limbs.size()) return result;
+	result.limbs.assign(a.limbs.begin() + (std::ptrdiff_t)count, a.limbs.end());
+	result.negative = a.negative;
+	return result;
+}
+
+// The magnitude divided by a divisor that is known to divide it.
+bigInteger divideExact(const bigInteger &a, const uint32_t divisor)
+{
+	bigInteger result = a;
+	uint64_t remainder = 0;
+	for(std::size_t i = result.limbs.size(); i > 0; i--)
+	{
+		uint64_t current = remainder * BIG_BASE + result.limbs[i - 1];
+		result.limbs[i - 1] = (uint32_t)(current / divisor);
+		remainder = current % divisor;
+	}
+	trimLimbs(result.limbs);
+	result.negative = a.negative && !result.isZero();
+	return result;
+}
+
+// Limbs [start, start + count) of a, as a non-negative number.
+bigInteger limbSlice(const uint32_t *a, const std::size_t na, const std::size_t start, const std::size_t count)
+{
+	bigInteger result;
+	if(start < na) result.limbs.assign(a + start, a + (na - start < count ? na : start + count));
+	trimLimbs(result.limbs);
+	return result;
+}
+
+// Splits both operands into three parts of a third of the longer one and
+// multiplies the polynomials a2 x^2 + a1 x + a0 and b2 x^2 + b1 x + b0 from
+// their products at 0, 1, -1, -2 and infinity: five multiplications of a
+// third of the size instead of nine. The points give signed values, so the
+// evaluation and the interpolation (Bodrato's sequence) use bigInteger.
+limbVector toom3Multiply(const uint32_t *a, const std::size_t na, const uint32_t *b, const std::size_t nb)
+{
+	const std::size_t third = ((na > nb ? na : nb) + 2) / 3;
+	bigInteger a0 = limbSlice(a, na, 0, third), a1 = limbSlice(a, na, third, third), a2 = limbSlice(a, na, 2 * third, third);
+	bigInteger b0 = limbSlice(b, nb, 0, third), b1 = limbSlice(b, nb, third, third), b2 = limbSlice(b, nb, 2 * third, third);
+	bigInteger aEven = a0 + a2;
+	bigInteger bEven = b0 + b2;
+	bigInteger aOne = aEven + a1, bOne = bEven + b1;
+	bigInteger aMinusOne = aEven - a1, bMinusOne = bEven - b1;
+	bigInteger aMinusTwo = multiplySmall(aMinusOne + a2, 2) - a0;
+	bigInteger bMinusTwo = multiplySmall(bMinusOne + b2, 2) - b0;
+	bigInteger r0 = a0 * b0;
+	bigInteger r1 = aOne * bOne;
+	bigInteger rMinusOne = aMinusOne * bMinusOne;
+	bigInteger r3 = aMinusTwo * bMinusTwo;
+	bigInteger rInfinity = a2 * b2;
+	r3 = divideExact(r3 - r1, 3);
+	r1 = divideExact(r1 - rMinusOne, 2);
+	bigInteger r2 = rMinusOne - r0;
+	r3 = divideExact(r2 - r3, 2) + multiplySmall(rInfinity, 2);
+	r2 = r2 + r1 - rInfinity;
+	r1 = r1 - r3;
+	limbVector result = r0.limbs;
+	addLimbsAt(result, r1.limbs.data(), r1.limbs.size(), third);
+	addLimbsAt(result, r2.limbs.data(), r2.limbs.size(), 2 * third);
+	addLimbsAt(result, r3.limbs.data(), r3.limbs.size(), 3 * third);
+	addLimbsAt(result, rInfinity.limbs.data(), rInfinity.limbs.size(), 4 * third);
+	trimLimbs(result);
+	return result;
+}
+
+// One step of the given algorithm; the smaller products inside it go back
+// through multiplyLimbs. MULTIPLY_AUTO is multiplyLimbs itself.
+limbVector multiplyWith(const multiplyAlgorithm algorithm, const uint32_t *a, std::size_t na, const uint32_t *b, std::size_t nb)
+{
+	while(na > 0 && a[na - 1] == 0) na--;
+	while(nb > 0 && b[nb - 1] == 0) nb--;
+	if(na == 0 || nb == 0) return limbVector();
+	const std::size_t shorter = na < nb ? na : nb;
+	const std::size_t longer = na < nb ? nb : na;
+	multiplyAlgorithm chosen = algorithm;
+	if(chosen == MULTIPLY_AUTO)
+	{
+		if(shorter < KARATSUBA_THRESHOLD) chosen = MULTIPLY_SCHOOLBOOK;
+		else if(shorter >= NTT_THRESHOLD && nttSupports(na, nb)) chosen = MULTIPLY_NTT;
+		else if(2 * shorter <= longer) return chunkedMultiply(a, na, b, nb);
+		else chosen = shorter >= TOOM3_THRESHOLD ? MULTIPLY_TOOM3 : MULTIPLY_KARATSUBA;
+	}
+	if(chosen == MULTIPLY_NTT && !nttSupports(na, nb)) chosen = MULTIPLY_TOOM3;
+	switch(chosen)
+	{
+		case MULTIPLY_SCHOOLBOOK: return schoolbookMultiply(a, na, b, nb);
+		case MULTIPLY_KARATSUBA: return karatsubaMultiply(a, na, b, nb);
+		case MULTIPLY_TOOM3: return toom3Multiply(a, na, b, nb);
+		default: return nttMultiply <BIG_BASE> (a, na, b, nb);
+	}
+}
+
+limbVector multiplyLimbs(const uint32_t *a, std::size_t na, const uint32_t *b, std::size_t nb)
+{
+	return multiplyWith(MULTIPLY_AUTO, a, na, b, nb);
+}
+
+#endif
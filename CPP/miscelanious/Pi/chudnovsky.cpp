@@ -0,0 +1,72 @@
+#ifndef CHUDNOVSKY_CPP
+#define CHUDNOVSKY_CPP
+
+// pi from the Chudnovsky series, about 14.18 digits per term:
+// 1/pi = 12 / 640320^(3/2) * sum (-1)^k (6k)! (13591409 + 545140134 k) / ((3k)! (k!)^3 640320^(3k)).
+// Binary splitting sums terms [a, b) as integers P, Q and T, halving the
+// range each time, so the whole series costs a few big multiplications
+// near the top instead of one division per term. Then
+// pi = 426880 sqrt(10005) Q / T.
+
+#include <cstdint>
+#include <string>
+#include "bigFloat.cpp"
+#include "bigInteger.cpp"
+
+const double DIGITS_PER_TERM = 14.181647462725477;
+const long long CHUDNOVSKY_A = 13591409;
+const long long CHUDNOVSKY_B = 545140134;
+// 640320^3 / 24
+const long long CHUDNOVSKY_C3_OVER_24 = 10939058860032000LL;
+const uint32_t CHUDNOVSKY_SQRT_FACTOR = 426880;
+const uint32_t CHUDNOVSKY_RADICAND = 10005;
+
+struct splitTerms
+{
+	bigInteger p;
+	bigInteger q;
+	bigInteger t;
+};
+
+splitTerms binarySplit(const long long a, const long long b)
+{
+	splitTerms result;
+	if(b - a == 1)
+	{
+		if(a == 0)
+		{
+			result.p = bigInteger(1);
+			result.q = bigInteger(1);
+		}else
+		{
+			result.p = multiplySmall(multiplySmall(bigInteger(6 * a - 5), (uint32_t)(2 * a - 1)), (uint32_t)(6 * a - 1));
+			result.q = multiplySmall(multiplySmall(multiplySmall(bigInteger(CHUDNOVSKY_C3_OVER_24), (uint32_t)a), (uint32_t)a), (uint32_t)a);
+		}
+		result.t = result.p * bigInteger(CHUDNOVSKY_A + CHUDNOVSKY_B * a);
+		if(a % 2 == 1) result.t = -result.t;
+		return result;
+	}
+	long long middle = a + (b - a) / 2;
+	splitTerms left = binarySplit(a, middle);
+	splitTerms right = binarySplit(middle, b);
+	result.t = left.t * right.q + left.p * right.t;
+	result.p = left.p * right.p;
+	result.q = left.q * right.q;
+	return result;
+}
+
+// pi with `digits` decimals, cut off rather than rounded.
+std::string computePi(const std::size_t digits)
+{
+	const long long terms = (long long)((double)digits / DIGITS_PER_TERM) + 2;
+	const std::size_t limbs = digits / BIG_BASE_DIGITS + 2;
+	splitTerms sum = binarySplit(0, terms);
+	bigFloat numerator(multiplySmall(multiplySmall(sum.q, CHUDNOVSKY_SQRT_FACTOR), CHUDNOVSKY_RADICAND));
+	// sqrt(10005) = 10005 / sqrt(10005), so no square root is needed.
+	bigFloat root = inverseSquareRoot(bigFloat(bigInteger(CHUDNOVSKY_RADICAND)), limbs);
+	bigFloat inverseT = reciprocal(bigFloat(sum.t), limbs);
+	bigFloat pi = multiply(multiply(truncateTo(numerator, limbs + GUARD_LIMBS), inverseT, limbs + GUARD_LIMBS), root, limbs + GUARD_LIMBS);
+	return toDecimal(pi, digits);
+}
+
+#endif
@@ -1,25 +1,39 @@
-#include <math.h>
-#include <iostream>
-#include <iomanip>
-
-const unsigned long long int ITERATIONS = 10000;
-
-long double getPi()
-{
-	long double pi = 4;
-	bool negative = 1;
-	for(unsigned int i = 3; i < ITERATIONS; i += 2)
-	{
-		if(negative) pi -= 4.0 / i;
-		else pi += 4.0 / i;
-		negative = !negative;
-	}
-	std::cout << std::setprecision(2000) << pi << std::endl;
-	return pi;
-}
-
-int main()
-{
-	getPi();
-	return 0;
-}
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "chudnovsky.cpp"
+
+const std::size_t DEFAULT_DIGITS = 2000;
+
+// Prints pi to stdout and the time it took to stderr.
+std::string getPi(const std::size_t digits)
+{
+	auto start = std::chrono::steady_clock::now();
+	std::string pi = computePi(digits);
+	double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+	std::cout << pi << std::endl;
+	std::cerr << digits << " digits in " << seconds << " s" << std::endl;
+	return pi;
+}
+
+// A positive decimal number and nothing else, so "-5" cannot wrap around.
+bool parseDigits(const char *text, std::size_t &digits)
+{
+	const char *end = text + std::strlen(text);
+	std::from_chars_result result = std::from_chars(text, end, digits);
+	return result.ec == std::errc() && result.ptr == end && digits > 0;
+}
+
+int main(int argc, char **argv)
+{
+	std::size_t digits = DEFAULT_DIGITS;
+	if(argc > 2 || (argc > 1 && !parseDigits(argv[1], digits)))
+	{
+		std::cerr << "Usage: pi [digits], digits a positive number, " << DEFAULT_DIGITS << " by default" << std::endl;
+		return 1;
+	}
+	getPi(digits);
+	return 0;
+}
@@ -0,0 +1,153 @@
+#ifndef NUMBER_THEORETIC_TRANSFORM_CPP
+#define NUMBER_THEORETIC_TRANSFORM_CPP
+
+// Products of huge limb vectors in O(n log n): the limbs are convolved with
+// number-theoretic transforms modulo three NTT-friendly primes and each
+// coefficient is rebuilt from its three residues with the Chinese remainder
+// theorem (Garner's form). A coefficient is at most n * (10^9)^2, and the
+// product of the primes, about 7.9e25, covers that for every supported
+// length. The smallest 2^k dividing p - 1 caps the length at 2^23 limbs.
+// Products inside the transforms use Montgomery reduction, which replaces
+// the 64-bit remainder with two multiplications: the twiddle factors are
+// kept multiplied by 2^32 so that reducing a * w gives a * w mod p directly.
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+const uint32_t NTT_PRIME_1 = 998244353;
+const uint32_t NTT_PRIME_2 = 167772161;
+const uint32_t NTT_PRIME_3 = 469762049;
+// 3 is a primitive root of all three primes.
+const uint32_t NTT_ROOT = 3;
+const std::size_t NTT_MAX_LENGTH = std::size_t(1) << 23;
+
+template <uint32_t MOD>
+uint32_t powerMod(uint32_t base, uint64_t exponent)
+{
+	uint64_t result = 1;
+	uint64_t b = base % MOD;
+	for(; exponent > 0; exponent >>= 1)
+	{
+		if(exponent & 1) result = result * b % MOD;
+		b = b * b % MOD;
+	}
+	return (uint32_t)result;
+}
+
+// -MOD^-1 modulo 2^32; every Newton step doubles the correct low bits.
+template <uint32_t MOD>
+constexpr uint32_t montgomeryFactor()
+{
+	uint32_t inverse = MOD;
+	for(int i = 0; i < 4; i++) inverse *= 2 - MOD * inverse;
+	return 0 - inverse;
+}
+
+// t / 2^32 mod MOD, for t < MOD * 2^32.
+template <uint32_t MOD>
+inline uint32_t montgomeryReduce(const uint64_t t)
+{
+	uint32_t m = (uint32_t)t * montgomeryFactor <MOD> ();
+	uint32_t u = (uint32_t)((t + (uint64_t)m * MOD) >> 32);
+	return u >= MOD ? u - MOD : u;
+}
+
+// a * 2^32 mod MOD
+template <uint32_t MOD>
+uint32_t toMontgomery(const uint32_t a) { return (uint32_t)(((uint64_t)a << 32) % MOD); }
+
+template <uint32_t MOD>
+void transform(std::vector <uint32_t> &a, const bool inverse)
+{
+	const std::size_t n = a.size();
+	for(std::size_t i = 1, j = 0; i < n; i++)
+	{
+		std::size_t bit = n >> 1;
+		for(; j & bit; bit >>= 1) j ^= bit;
+		j ^= bit;
+		if(i < j) std::swap(a[i], a[j]);
+	}
+	// Powers of a primitive n-th root; a stage of length L takes every n/L-th.
+	std::vector <uint32_t> roots(n / 2 > 0 ? n / 2 : 1);
+	uint32_t step = powerMod <MOD> (NTT_ROOT, (MOD - 1) / n);
+	if(inverse) step = powerMod <MOD> (step, MOD - 2);
+	const uint32_t stepMontgomery = toMontgomery <MOD> (step);
+	roots[0] = toMontgomery <MOD> (1);
+	for(std::size_t k = 1; k < n / 2; k++) roots[k] = montgomeryReduce <MOD> ((uint64_t)roots[k - 1] * stepMontgomery);
+	for(std::size_t length = 2; length <= n; length <<= 1)
+	{
+		const std::size_t half = length / 2;
+		const std::size_t stride = n / length;
+		for(std::size_t start = 0; start < n; start += length)
+		{
+			for(std::size_t k = 0; k < half; k++)
+			{
+				uint32_t u = a[start + k];
+				uint32_t v = montgomeryReduce <MOD> ((uint64_t)a[start + k + half] * roots[k * stride]);
+				a[start + k] = u + v >= MOD ? u + v - MOD : u + v;
+				a[start + k + half] = u >= v ? u - v : u + MOD - v;
+			}
+		}
+	}
+	if(!inverse) return;
+	// Also undoes the 2^-32 the pointwise products in convolveMod leave behind.
+	const uint32_t scale = toMontgomery <MOD> (toMontgomery <MOD> (powerMod <MOD> ((uint32_t)(n % MOD), MOD - 2)));
+	for(std::size_t i = 0; i < n; i++) a[i] = montgomeryReduce <MOD> ((uint64_t)a[i] * scale);
+}
+
+// The cyclic convolution of a and b modulo MOD, `size` coefficients long.
+template <uint32_t MOD>
+std::vector <uint32_t> convolveMod(const uint32_t *a, const std::size_t na, const uint32_t *b, const std::size_t nb, const std::size_t size)
+{
+	std::vector <uint32_t> fa(size, 0);
+	std::vector <uint32_t> fb(size, 0);
+	for(std::size_t i = 0; i < na; i++) fa[i] = a[i] % MOD;
+	for(std::size_t i = 0; i < nb; i++) fb[i] = b[i] % MOD;
+	transform <MOD> (fa, false);
+	transform <MOD> (fb, false);
+	for(std::size_t i = 0; i < size; i++) fa[i] = montgomeryReduce <MOD> ((uint64_t)fa[i] * fb[i]);
+	transform <MOD> (fa, true);
+	return fa;
+}
+
+bool nttSupports(const std::size_t na, const std::size_t nb) { return na + nb <= NTT_MAX_LENGTH; }
+
+// a * b for limbs in base BASE, without leading zero limbs.
+template <uint32_t BASE>
+std::vector <uint32_t> nttMultiply(const uint32_t *a, const std::size_t na, const uint32_t *b, const std::size_t nb)
+{
+	std::size_t size = 1;
+	while(size < na + nb - 1) size <<= 1;
+	std::vector <uint32_t> r1 = convolveMod <NTT_PRIME_1> (a, na, b, nb, size);
+	std::vector <uint32_t> r2 = convolveMod <NTT_PRIME_2> (a, na, b, nb, size);
+	std::vector <uint32_t> r3 = convolveMod <NTT_PRIME_3> (a, na, b, nb, size);
+	const uint64_t inverse1Mod2 = powerMod <NTT_PRIME_2> (NTT_PRIME_1, NTT_PRIME_2 - 2);
+	const uint64_t inverse12Mod3 = powerMod <NTT_PRIME_3> ((uint32_t)((uint64_t)NTT_PRIME_1 * NTT_PRIME_2 % NTT_PRIME_3), NTT_PRIME_3 - 2);
+	// x1 + x2 p1 + x3 p1 p2 is too big for 64 bits, so both terms are split
+	// at BASE and the carry holds the higher parts.
+	const uint64_t prime12 = (uint64_t)NTT_PRIME_1 * NTT_PRIME_2;
+	const uint64_t prime12Low = prime12 % BASE;
+	const uint64_t prime12High = prime12 / BASE;
+	std::vector <uint32_t> result(na + nb, 0);
+	uint64_t carry = 0;
+	for(std::size_t i = 0; i < na + nb; i++)
+	{
+		uint64_t high = 0;
+		if(i < na + nb - 1)
+		{
+			uint64_t x1 = r1[i];
+			uint64_t x2 = (r2[i] + NTT_PRIME_2 - x1 % NTT_PRIME_2) % NTT_PRIME_2 * inverse1Mod2 % NTT_PRIME_2;
+			uint64_t low = x1 + x2 * NTT_PRIME_1;
+			uint64_t x3 = (r3[i] + NTT_PRIME_3 - low % NTT_PRIME_3) % NTT_PRIME_3 * inverse12Mod3 % NTT_PRIME_3;
+			carry += low % BASE + x3 * prime12Low;
+			high = low / BASE + x3 * prime12High;
+		}
+		result[i] = (uint32_t)(carry % BASE);
+		carry = carry / BASE + high;
+	}
+	while(!result.empty() && result.back() == 0) result.pop_back();
+	return result;
+}
+
+#endif
@@ -1,10 +1,15 @@
+#ifndef BRYDZ_CPP
+#define BRYDZ_CPP
+
 #include <iostream>
+#include <string>
 #include <vector>
+#include "historia.cpp"
 
 const std::vector <std::string> ATUTY = {"BA", "Trefl", "Karo", "Kier", "Pik"};
 const bool A_ID = 0;
 const bool B_ID = 1;
-const std::vector <std::string> GRACZE = {};
+const std::vector <std::string> GRACZE = {"My", "Oni"};
 const std::vector <std::string> PO_PARTII {"Nikt", GRACZE[A_ID], GRACZE[B_ID], "Obaj Gracze"};
 const int DOMYSLNE_LEWY = 6;
 const int BEZ_ATUTU_ID = 1;
@@ -24,15 +29,38 @@ void print(const std::string s)
 	std::cout << s << std::endl;
 }
 
-void tabela(std::vector <int> punktyA, std::vector <int> punktyB)
+void naglowekTabeli()
 {
-
 	std::cout << "Numer Gry" << "    Po Partii" << "          " << GRACZE[A_ID] << "    " << GRACZE[B_ID] << std::endl;
-	for(int i = 0; i < punktyA.size(); i++)
-	{
+}
+
+void wierszTabeli(uint64_t numerGry, int punktyA, int punktyB)
+{
+	std::cout << numerGry + 1 << "            " << PO_PARTII[numerGry % CYKL_PO_PARTII] << "               " << punktyA << "                 " <<  punktyB << std::endl;
+}
+
+void sumaTabeli(long long sumaA, long long sumaB)
+{
+	std::cout << "Razem" << "                              " << sumaA << "                 " << sumaB << std::endl;
+}
 
-		std::cout << i + 1 << "            " << PO_PARTII[i % CYKL_PO_PARTII] << "               " << punktyA[i] << "                 " <<  punktyB[i] << std::endl;
+// Pelna tabela jednej sesji czytana z historii, wypisywana tylko na koniec gry;
+// w trakcie gry tabela jest dopisywana po jednym wierszu.
+void tabela(Historia &historia, uint64_t sesja)
+{
+	historia.odswiez();
+	if(sesja >= historia.sesje()) return;
+	long long sumaA = 0;
+	long long sumaB = 0;
+	naglowekTabeli();
+	for(uint64_t i = historia.poczatek(sesja); i < historia.koniec(sesja); i++)
+	{
+		const RekordRozdania &rekord = historia.rekord(i);
+		wierszTabeli(i - historia.poczatek(sesja), rekord.punktyA, rekord.punktyB);
+		sumaA += rekord.punktyA;
+		sumaB += rekord.punktyB;
 	}
+	sumaTabeli(sumaA, sumaB);
 }
 
 void lwyAtut(int lwy, int atut)
@@ -158,69 +186,69 @@ int ileWpadek()
 }
 
 void punkty(std::vector <int> &punktyA, std::vector <int> &punktyB, int lwy, int atut, bool kontraBool, bool rekontraBool,
-int ktoraGra, int ktoKontraktI, bool rozgrywajacyWygral, int wpadki)
+int ktoraGra, int ktoKontraktI, bool rozgrywajacyWygral, int wpadki, std::ostream &wyjscie = std::cout)
 {
 	int sumaPunktow = 0;
 	if(rozgrywajacyWygral)
 	{
 		int zdobyteLewy = ILOSC_LEW - wpadki - DOMYSLNE_LEWY;
 		int nadrobki = zdobyteLewy - lwy;
-		int punktyZaLew;
-		std::cout << "wartosc kontraBool: " << kontraBool << "; wartosc rekontraBool: " << rekontraBool << std::endl;
+		int punktyZaLew = 0;
+		wyjscie << "wartosc kontraBool: " << kontraBool << "; wartosc rekontraBool: " << rekontraBool << std::endl;
 
 		// Lewy Deklarowane
 		if(atut == TREFL_ID || atut == KARO_ID)
 		{
-			print("kontrakt TREFL lub KARO kazda karta kontraktowa za 20");
+			wyjscie << "kontrakt TREFL lub KARO kazda karta kontraktowa za 20" << std::endl;
 			punktyZaLew = 20;
 			if(kontraBool)
 			{
-				print("kontra TREFL lub KARO, kazda karta kontraktowa za 40");
+				wyjscie << "kontra TREFL lub KARO, kazda karta kontraktowa za 40" << std::endl;
 				punktyZaLew = 40;
 			}
 			if(rekontraBool)
 			{
-				print("rekontra TREFL lub KARO, kazda karta kontraktowa za 80");
+				wyjscie << "rekontra TREFL lub KARO, kazda karta kontraktowa za 80" << std::endl;
 				punktyZaLew = 80;
 			}
 
-			std::cout << "Ilosc lew w kontrakcie: " << lwy << " do punktow dodaje sie " << lwy * punktyZaLew << std::endl;
+			wyjscie << "Ilosc lew w kontrakcie: " << lwy << " do punktow dodaje sie " << lwy * punktyZaLew << std::endl;
 			sumaPunktow += (lwy * punktyZaLew);
 		}
 
 		if(atut == KIER_ID || atut == PIK_ID)
 		{
-			print("kontrakt KIER lub PIK, kazda kontraktowa 30");
+			wyjscie << "kontrakt KIER lub PIK, kazda kontraktowa 30" << std::endl;
 			punktyZaLew = 30;
 			if(kontraBool)
 			{
-				print("kontra KIER lub PIK, kazda kontraktowa za 60");
+				wyjscie << "kontra KIER lub PIK, kazda kontraktowa za 60" << std::endl;
 				punktyZaLew = 60;
 			}
 			if(rekontraBool)
 			{
-				print("rekontra KIER lub PIK, kazda kontraktowa za 120");
+				wyjscie << "rekontra KIER lub PIK, kazda kontraktowa za 120" << std::endl;
 				punktyZaLew = 120;
 			}
 
-			std::cout << "Ilosc lew w kontrakcie: " << lwy << " do punktow dodaje sie " << lwy * punktyZaLew << std::endl;
+			wyjscie << "Ilosc lew w kontrakcie: " << lwy << " do punktow dodaje sie " << lwy * punktyZaLew << std::endl;
 			sumaPunktow += (lwy * punktyZaLew);
 		}
 
 		if(atut == BEZ_ATUTU_ID)
 		{
 			punktyZaLew = 30;
-			print("kontrakt BEZ_ATUTU, pierwsza lewa za 40, kazda nastepna za 30");
+			wyjscie << "kontrakt BEZ_ATUTU, pierwsza lewa za 40, kazda nastepna za 30" << std::endl;
 			sumaPunktow = 40;
 			if(kontraBool)
 			{
-				print("kontrakt BEZ_ATUTU, pierwsza lewa za 80, kazda nastepna za 60");
+				wyjscie << "kontrakt BEZ_ATUTU, pierwsza lewa za 80, kazda nastepna za 60" << std::endl;
 				sumaPunktow = 80;
 				punktyZaLew = 60;
 			}
 			if(rekontraBool)
 			{
-				print("kontrakt BEZ_ATUTU, pierwsza lewa za 160, kazda nastepna za 120");
+				wyjscie << "kontrakt BEZ_ATUTU, pierwsza lewa za 160, kazda nastepna za 120" << std::endl;
 				sumaPunktow = 160;
 				punktyZaLew = 120;
 			}
@@ -275,7 +303,7 @@ int ktoraGra, int ktoKontraktI, bool rozgrywajacyWygral, int wpadki)
 		if(kontraBool && !rekontraBool) sumaPunktow += 50;
 
 		if(kontraBool && rekontraBool) sumaPunktow += 100;
-		std::cout << "Rozgrywajacy zdobyl: " << sumaPunktow << std::endl;
+		wyjscie << "Rozgrywajacy zdobyl: " << sumaPunktow << std::endl;
 		if(ktoKontraktI == A_ID)
 		{
 			punktyA.push_back(sumaPunktow);
@@ -357,7 +385,7 @@ int ktoraGra, int ktoKontraktI, bool rozgrywajacyWygral, int wpadki)
 				}
 			}
 		}
-		std::cout << "Broniacy zdobyli: " << sumaPunktow << std::endl;
+		wyjscie << "Broniacy zdobyli: " << sumaPunktow << std::endl;
 		if(ktoKontraktI == A_ID)
 		{
 			punktyB.push_back(sumaPunktow);
@@ -379,9 +407,24 @@ bool gra()
 	bool koniecGry = 0;
 	std::vector <int> punktyA;
 	std::vector <int> punktyB;
+	Historia historia;
+	if(!historia.otworz(HISTORIA_PLIK, HISTORIA_INDEKS))
+	{
+		print("Nie mozna otworzyc historii rozdan!");
+		return 0;
+	}
+	historia.nowaSesja();
+	uint64_t sesja = historia.sesje();
+	if(sesja > 0)
+	{
+		std::cout << "Poprzednia sesja nr " << sesja << ":" << std::endl;
+		tabela(historia, sesja - 1);
+	}
+	long long sumaA = 0;
+	long long sumaB = 0;
+	naglowekTabeli();
 	do{
-		int ktoraGra = 0;
-		tabela(punktyA, punktyB);
+		int ktoraGra = (int)historia.rozdanWSesji();
 		int ktoKontraktI = ktoKontrakt();
 		int lwy = zagraneLwy();
 		int atut = zagranyAtut(lwy);
@@ -396,15 +439,37 @@ bool gra()
 		if( zebraneLewy >= lwy + DOMYSLNE_LEWY) rozgrywajacyWygral = 1;
 		else rozgrywajacyWygral = 0;
 		punkty(punktyA, punktyB, lwy, atut, kontraBool, rekontraBool, ktoraGra, ktoKontraktI, rozgrywajacyWygral, wpadki);
+
+		RekordRozdania rekord;
+		rekord.punktyA = punktyA.back();
+		rekord.punktyB = punktyB.back();
+		rekord.sesja = (uint32_t)sesja;
+		rekord.lwy = (uint8_t)lwy;
+		rekord.atut = (uint8_t)atut;
+		rekord.wpadki = (uint8_t)wpadki;
+		rekord.flagi = (uint8_t)((kontraBool ? FLAGA_KONTRA : 0) | (rekontraBool ? FLAGA_REKONTRA : 0) |
+		(rozgrywajacyWygral ? FLAGA_WYGRANY : 0) | (ktoKontraktI == B_ID ? FLAGA_KONTRAKT_B : 0));
+		if(!historia.dopisz(rekord)) print("Nie udalo sie zapisac rozdania do historii!");
+		sumaA += rekord.punktyA;
+		sumaB += rekord.punktyB;
+		punktyA.clear();
+		punktyB.clear();
+		wierszTabeli((uint64_t)ktoraGra, rekord.punktyA, rekord.punktyB);
+		sumaTabeli(sumaA, sumaB);
+
 		print("Czy koniec gry? 1 - TAK, 0 - NIE");
 		std::cin >> koniecGry;
 	}while(!koniecGry);
-	tabela(punktyA, punktyB);
+	tabela(historia, sesja);
 	return 0;
 }
 
+#ifndef BRYDZ_BEZ_MAIN
 int main()
 {
 	while(gra());
 	return 0;
 }
+#endif
+
+#endif
@@ -0,0 +1,195 @@
+#ifndef HISTORIA_CPP
+#define HISTORIA_CPP
+
+// Historia rozdan: plik tylko do dopisywania ze stalej dlugosci rekordami
+// oraz indeks sesji (numer pierwszego rekordu kazdej sesji). Przy starcie
+// oba pliki sa mapowane do pamieci, niczego nie trzeba parsowac.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char HISTORIA_PLIK[] = "historia.bin";
+const char HISTORIA_INDEKS[] = "historia.idx";
+const char HISTORIA_MAGIA[8] = {'B', 'R', 'Y', 'D', 'Z', 'H', 'I', 'S'};
+const uint32_t HISTORIA_WERSJA = 1;
+
+const uint8_t FLAGA_KONTRA = 1;
+const uint8_t FLAGA_REKONTRA = 2;
+const uint8_t FLAGA_WYGRANY = 4;
+const uint8_t FLAGA_KONTRAKT_B = 8;
+
+struct NaglowekHistorii
+{
+	char magia[8];
+	uint32_t wersja;
+	uint32_t rozmiarRekordu;
+	// Rekord jest zatwierdzony dopiero, gdy licznik w naglowku go obejmuje,
+	// wiec przerwany zapis zostawia najwyzej smieci za ostatnim rekordem.
+	uint64_t ileRekordow;
+};
+
+struct RekordRozdania
+{
+	int32_t punktyA;
+	int32_t punktyB;
+	uint32_t sesja;
+	uint8_t lwy;
+	uint8_t atut;
+	uint8_t wpadki;
+	uint8_t flagi;
+};
+
+static_assert(sizeof(NaglowekHistorii) == 24, "naglowek historii musi miec staly rozmiar");
+static_assert(sizeof(RekordRozdania) == 16, "rekord rozdania musi miec staly rozmiar");
+
+class Historia
+{
+	int plik = -1;
+	int indeks = -1;
+	const unsigned char *mapa = nullptr;
+	std::size_t rozmiarMapy = 0;
+	const uint64_t *mapaIndeksu = nullptr;
+	std::size_t rozmiarMapyIndeksu = 0;
+	uint64_t ileRekordow = 0;
+	uint64_t ileSesji = 0;
+	uint64_t poczatekSesji = 0;
+	// Czy biezaca sesja ma juz wpis w indeksie, dodawany przy pierwszym rozdaniu.
+	bool sesjaWIndeksie = false;
+
+	void odmapuj()
+	{
+		if(mapa) munmap((void *)mapa, rozmiarMapy);
+		if(mapaIndeksu) munmap((void *)mapaIndeksu, rozmiarMapyIndeksu);
+		mapa = nullptr;
+		mapaIndeksu = nullptr;
+	}
+
+	static const void *mapuj(const int fd, const std::size_t rozmiar)
+	{
+		if(rozmiar == 0) return nullptr;
+		void *m = mmap(nullptr, rozmiar, PROT_READ, MAP_SHARED, fd, 0);
+		return m == MAP_FAILED ? nullptr : m;
+	}
+
+public:
+	~Historia()
+	{
+		odmapuj();
+		if(plik >= 0) close(plik);
+		if(indeks >= 0) close(indeks);
+	}
+
+	bool otworz(const char *sciezka, const char *sciezkaIndeksu)
+	{
+		plik = open(sciezka, O_RDWR | O_CREAT, 0644);
+		indeks = open(sciezkaIndeksu, O_RDWR | O_CREAT, 0644);
+		if(plik < 0 || indeks < 0) return false;
+
+		NaglowekHistorii naglowek;
+		if(pread(plik, &naglowek, sizeof(naglowek), 0) != (ssize_t)sizeof(naglowek))
+		{
+			std::memcpy(naglowek.magia, HISTORIA_MAGIA, sizeof(HISTORIA_MAGIA));
+			naglowek.wersja = HISTORIA_WERSJA;
+			naglowek.rozmiarRekordu = sizeof(RekordRozdania);
+			naglowek.ileRekordow = 0;
+			if(pwrite(plik, &naglowek, sizeof(naglowek), 0) != (ssize_t)sizeof(naglowek)) return false;
+			if(ftruncate(indeks, 0) != 0) return false;
+		}
+		if(std::memcmp(naglowek.magia, HISTORIA_MAGIA, sizeof(HISTORIA_MAGIA)) != 0 ||
+		   naglowek.wersja != HISTORIA_WERSJA || naglowek.rozmiarRekordu != sizeof(RekordRozdania)) return false;
+		ileRekordow = naglowek.ileRekordow;
+
+		// Naglowek moze liczyc rekordy, ktorych nie ma w pliku (obciety lub
+		// uszkodzony plik); mapowanie za koncem pliku konczy sie SIGBUS.
+		struct stat info;
+		if(fstat(plik, &info) != 0 || (uint64_t)info.st_size < sizeof(NaglowekHistorii)) return false;
+		uint64_t rekordyWPliku = ((uint64_t)info.st_size - sizeof(NaglowekHistorii)) / sizeof(RekordRozdania);
+		if(ileRekordow > rekordyWPliku)
+		{
+			ileRekordow = rekordyWPliku;
+			if(pwrite(plik, &ileRekordow, sizeof(ileRekordow), offsetof(NaglowekHistorii, ileRekordow)) != (ssize_t)sizeof(ileRekordow)) return false;
+		}
+
+		if(fstat(indeks, &info) != 0) return false;
+		ileSesji = (uint64_t)info.st_size / sizeof(uint64_t);
+		odswiez();
+		// Indeks konczy sie na pierwszym wpisie, ktory nie zaczyna niepustej
+		// sesji po poprzedniej, np. po awarii miedzy zapisem indeksu i rekordu.
+		uint64_t wszystkieSesje = ileSesji;
+		for(uint64_t i = 0; i < wszystkieSesje; i++)
+		{
+			if(mapaIndeksu[i] >= ileRekordow || (i > 0 && mapaIndeksu[i] <= mapaIndeksu[i - 1]))
+			{
+				ileSesji = i;
+				break;
+			}
+		}
+		if(ileSesji != wszystkieSesje)
+		{
+			if(ftruncate(indeks, (off_t)(ileSesji * sizeof(uint64_t))) != 0) return false;
+			odswiez();
+		}
+		return true;
+	}
+
+	// Mapuje na nowo zatwierdzona czesc pliku, np. po dopisaniu rekordow.
+	void odswiez()
+	{
+		odmapuj();
+		rozmiarMapy = sizeof(NaglowekHistorii) + ileRekordow * sizeof(RekordRozdania);
+		mapa = (const unsigned char *)mapuj(plik, rozmiarMapy);
+		rozmiarMapyIndeksu = ileSesji * sizeof(uint64_t);
+		mapaIndeksu = (const uint64_t *)mapuj(indeks, rozmiarMapyIndeksu);
+	}
+
+	// Sesja trafia do indeksu dopiero z pierwszym rozdaniem, wiec gra
+	// przerwana przed pierwszym rozdaniem nie zostawia pustej sesji.
+	void nowaSesja()
+	{
+		poczatekSesji = ileRekordow;
+		sesjaWIndeksie = false;
+	}
+
+	// Rekord musi byc na dysku, zanim naglowek go policzy: inaczej po utracie
+	// zasilania licznik moglby obejmowac rekord, ktory nigdy nie zostal zapisany.
+	bool dopisz(const RekordRozdania &rekord)
+	{
+		if(!sesjaWIndeksie)
+		{
+			if(pwrite(indeks, &poczatekSesji, sizeof(poczatekSesji), (off_t)(ileSesji * sizeof(uint64_t))) != (ssize_t)sizeof(poczatekSesji)) return false;
+			ileSesji++;
+			sesjaWIndeksie = true;
+		}
+		off_t miejsce = (off_t)(sizeof(NaglowekHistorii) + ileRekordow * sizeof(RekordRozdania));
+		if(pwrite(plik, &rekord, sizeof(rekord), miejsce) != (ssize_t)sizeof(rekord)) return false;
+		if(fdatasync(plik) != 0) return false;
+		uint64_t nowaIlosc = ileRekordow + 1;
+		if(pwrite(plik, &nowaIlosc, sizeof(nowaIlosc), offsetof(NaglowekHistorii, ileRekordow)) != (ssize_t)sizeof(nowaIlosc)) return false;
+		ileRekordow = nowaIlosc;
+		return true;
+	}
+
+	uint64_t sesje() const { return ileSesji; }
+
+	uint64_t rozdanWSesji() const { return ileRekordow - poczatekSesji; }
+
+	uint64_t poczatek(const uint64_t sesja) const { return mapaIndeksu[sesja]; }
+
+	uint64_t koniec(const uint64_t sesja) const
+	{
+		return sesja + 1 < ileSesji ? mapaIndeksu[sesja + 1] : ileRekordow;
+	}
+
+	// Odczyt z mapy, wazny dla rekordow sprzed ostatniego odswiez().
+	const RekordRozdania &rekord(const uint64_t i) const
+	{
+		return *(const RekordRozdania *)(mapa + sizeof(NaglowekHistorii) + i * sizeof(RekordRozdania));
+	}
+};
+
+#endif
@@ -0,0 +1,391 @@
+// Symulacja Monte Carlo rozdan brydzowych: znane rece (rozgrywajacego
+// i ewentualnie dziadka) zostaja na miejscu, reszta kart jest losowo
+// rozdawana, a kazde rozdanie jest oceniane heurystyka i liczone przez punkty().
+#define BRYDZ_BEZ_MAIN
+#include "brydz.cpp"
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int ILOSC_KART = 52;
+const int ILOSC_KOLOROW = 4;
+const int KART_W_KOLORZE = 13;
+const int ILOSC_REK = 4;
+const int N_ID = 0;
+const int E_ID = 1;
+const int S_ID = 2;
+const int W_ID = 3;
+const std::string FIGURY = "23456789TJQKA";
+const long long DOMYSLNA_ILOSC_ROZDAN = 1000000;
+const unsigned int MAKSYMALNIE_WATKOW = 256;
+
+// Karta to bit kolor * 13 + ranga; kolor 0 - Trefl, 1 - Karo, 2 - Kier, 3 - Pik,
+// ranga 0 - dwojka ... 12 - as. Reka to maska 52 bitow.
+typedef uint64_t Reka;
+
+struct Xoshiro256
+{
+	uint64_t s[4];
+
+	explicit Xoshiro256(uint64_t ziarno)
+	{
+		for(int i = 0; i < 4; i++)
+		{
+			ziarno += 0x9e3779b97f4a7c15ULL;
+			uint64_t z = ziarno;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			s[i] = z ^ (z >> 31);
+		}
+	}
+
+	static uint64_t obrot(const uint64_t x, const int k) { return (x << k) | (x >> (64 - k)); }
+
+	uint64_t operator()()
+	{
+		const uint64_t wynik = obrot(s[1] * 5, 7) * 9;
+		const uint64_t t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = obrot(s[3], 45);
+		return wynik;
+	}
+
+	// Liczba z przedzialu [0, n) metoda mnozenia Lemire'a, bez dzielenia.
+	uint32_t ponizej(const uint32_t n)
+	{
+		return (uint32_t)((((*this)() >> 32) * n) >> 32);
+	}
+};
+
+int ileKart(const Reka r) { return __builtin_popcountll(r); }
+
+uint32_t kolorReki(const Reka r, const int kolor)
+{
+	return (uint32_t)(r >> (kolor * KART_W_KOLORZE)) & ((1u << KART_W_KOLORZE) - 1);
+}
+
+// Reka w zapisie PBN: "AKQ2.KJ3.T98.A32" (piki.kiery.kara.trefle), "-" to nieznana reka.
+bool wczytajReke(const std::string &opis, Reka &reka)
+{
+	reka = 0;
+	if(opis == "-") return true;
+	int kolor = 3;
+	for(unsigned int i = 0; i < opis.size(); i++)
+	{
+		if(opis[i] == '.')
+		{
+			if(--kolor < 0) return false;
+			continue;
+		}
+		std::size_t ranga = FIGURY.find(opis[i]);
+		if(ranga == std::string::npos) return false;
+		Reka karta = 1ULL << (kolor * KART_W_KOLORZE + ranga);
+		if(reka & karta) return false;
+		reka |= karta;
+	}
+	return kolor == 0 && ileKart(reka) == KART_W_KOLORZE;
+}
+
+// Rozdaje brakujace karty do rak, ktore nie sa znane. Wolne karty trzymane
+// sa w tablicy, ktora jest tasowana w miejscu - permutacja permutacji jest
+// nadal losowa, wiec nie trzeba jej odtwarzac miedzy rozdaniami.
+struct Rozdawacz
+{
+	Reka znane[ILOSC_REK];
+	uint8_t wolne[ILOSC_KART];
+	int ileWolnych;
+
+	Rozdawacz(const Reka *znaneReki)
+	{
+		Reka zajete = 0;
+		for(int i = 0; i < ILOSC_REK; i++)
+		{
+			znane[i] = znaneReki[i];
+			zajete |= znane[i];
+		}
+		ileWolnych = 0;
+		for(int karta = 0; karta < ILOSC_KART; karta++)
+		{
+			if(!(zajete & (1ULL << karta))) wolne[ileWolnych++] = (uint8_t)karta;
+		}
+	}
+
+	void rozdaj(Xoshiro256 &los, Reka *reka)
+	{
+		for(int i = 0; i < ileWolnych - 1; i++)
+		{
+			int j = i + (int)los.ponizej((uint32_t)(ileWolnych - i));
+			uint8_t t = wolne[i];
+			wolne[i] = wolne[j];
+			wolne[j] = t;
+		}
+		int nastepna = 0;
+		for(int r = 0; r < ILOSC_REK; r++)
+		{
+			reka[r] = znane[r];
+			for(int k = ileKart(znane[r]); k < KART_W_KOLORZE; k++) reka[r] |= 1ULL << wolne[nastepna++];
+		}
+	}
+};
+
+int najwyzsza(const uint32_t kolor) { return 31 - __builtin_clz(kolor); }
+
+int najnizsza(const uint32_t kolor) { return __builtin_ctz(kolor); }
+
+// Rozgrywa kolor "na sile": jesli linia NS ma najwyzsza karte w kolorze,
+// wychodzi nia, a partner doklada najnizsza; jesli nie, obie rece NS
+// dokladaja najnizsze karty, a obroncy biora najtansza karta, ktora bije.
+// Zwraca ilosc lew wzietych przez NS, zanim dluzsza reka NS skonczy kolor.
+int lewyWKolorze(uint32_t n, uint32_t s, uint32_t e, uint32_t w)
+{
+	int lewy = 0;
+	while(n || s)
+	{
+		uint32_t ich = e | w;
+		int nasza = najwyzsza(n | s);
+		if(!ich || nasza > najwyzsza(ich))
+		{
+			lewy++;
+			if(n & (1u << nasza))
+			{
+				n &= ~(1u << nasza);
+				if(s) s &= ~(1u << najnizsza(s));
+			}else
+			{
+				s &= ~(1u << nasza);
+				if(n) n &= ~(1u << najnizsza(n));
+			}
+			if(e) e &= ~(1u << najnizsza(e));
+			if(w) w &= ~(1u << najnizsza(w));
+			continue;
+		}
+
+		int zagrana = -1;
+		if(n)
+		{
+			zagrana = najnizsza(n);
+			n &= ~(1u << zagrana);
+		}
+		if(s)
+		{
+			int zS = najnizsza(s);
+			s &= ~(1u << zS);
+			if(zS > zagrana) zagrana = zS;
+		}
+		int bijaca = najnizsza(ich & ~((2u << zagrana) - 1));
+		if(e & (1u << bijaca))
+		{
+			e &= ~(1u << bijaca);
+			if(w) w &= ~(1u << najnizsza(w));
+		}else
+		{
+			w &= ~(1u << bijaca);
+			if(e) e &= ~(1u << najnizsza(e));
+		}
+	}
+	return lewy;
+}
+
+// Heurystyczna ocena ilosci lew rozgrywajacego (N) z dziadkiem (S):
+// suma lew z rozegrania kazdego koloru, w kontrakcie kolorowym dodatkowo
+// przebitki krotszej reki atutowej i przebitki obroncow, gdy atuty
+// obroncow przetrwaja nasze.
+int ocenaLew(const Reka *reka, const int atut)
+{
+	int kolorAtutowy = atut - TREFL_ID;
+	bool bezAtutu = (atut == BEZ_ATUTU_ID);
+	uint32_t kolory[ILOSC_REK][ILOSC_KOLOROW];
+	for(int r = 0; r < ILOSC_REK; r++)
+	{
+		for(int k = 0; k < ILOSC_KOLOROW; k++) kolory[r][k] = kolorReki(reka[r], k);
+	}
+
+	bool obroncyPrzebijaja = false;
+	int przebitki = 0;
+	int krotszaAtutowa = S_ID;
+	int dluzszaAtutowa = N_ID;
+	if(!bezAtutu)
+	{
+		int atutyN = __builtin_popcount(kolory[N_ID][kolorAtutowy]);
+		int atutyS = __builtin_popcount(kolory[S_ID][kolorAtutowy]);
+		if(atutyN < atutyS)
+		{
+			krotszaAtutowa = N_ID;
+			dluzszaAtutowa = S_ID;
+		}
+		int naszeAtuty = atutyN > atutyS ? atutyN : atutyS;
+		int ichAtuty = __builtin_popcount(kolory[E_ID][kolorAtutowy]);
+		int atutyW = __builtin_popcount(kolory[W_ID][kolorAtutowy]);
+		if(atutyW > ichAtuty) ichAtuty = atutyW;
+		obroncyPrzebijaja = ichAtuty > naszeAtuty;
+		przebitki = atutyN < atutyS ? atutyN : atutyS;
+	}
+
+	int lewy = 0;
+	int mozliwePrzebitki = 0;
+	for(int k = 0; k < ILOSC_KOLOROW; k++)
+	{
+		int wKolorze = lewyWKolorze(kolory[N_ID][k], kolory[S_ID][k], kolory[E_ID][k], kolory[W_ID][k]);
+		if(!bezAtutu && k != kolorAtutowy)
+		{
+			if(obroncyPrzebijaja)
+			{
+				int dlugoscE = __builtin_popcount(kolory[E_ID][k]);
+				int dlugoscW = __builtin_popcount(kolory[W_ID][k]);
+				int limit = dlugoscE < dlugoscW ? dlugoscE : dlugoscW;
+				if(wKolorze > limit) wKolorze = limit;
+			}
+			int roznica = __builtin_popcount(kolory[dluzszaAtutowa][k]) - __builtin_popcount(kolory[krotszaAtutowa][k]);
+			if(roznica > 0) mozliwePrzebitki += roznica;
+		}
+		lewy += wKolorze;
+	}
+	lewy += mozliwePrzebitki < przebitki ? mozliwePrzebitki : przebitki;
+	return lewy > ILOSC_LEW ? ILOSC_LEW : lewy;
+}
+
+struct WynikSymulacji
+{
+	long long rozdan = 0;
+	long long wygranych = 0;
+	long long sumaPunktow = 0;
+	long long lewy[ILOSC_LEW + 1] = {};
+
+	void dodaj(const WynikSymulacji &inny)
+	{
+		rozdan += inny.rozdan;
+		wygranych += inny.wygranych;
+		sumaPunktow += inny.sumaPunktow;
+		for(int i = 0; i <= ILOSC_LEW; i++) lewy[i] += inny.lewy[i];
+	}
+};
+
+struct Kontrakt
+{
+	int lwy;
+	int atut;
+	bool kontra;
+	bool rekontra;
+	int poPartii;
+};
+
+void symulujWatek(Rozdawacz rozdawacz, const Kontrakt kontrakt, const long long ileRozdan, const uint64_t ziarno, WynikSymulacji &wynik)
+{
+	Xoshiro256 los(ziarno);
+	std::ostream cisza(nullptr);
+	std::vector <int> punktyA;
+	std::vector <int> punktyB;
+	punktyA.reserve(1);
+	punktyB.reserve(1);
+	Reka reka[ILOSC_REK];
+	for(long long i = 0; i < ileRozdan; i++)
+	{
+		rozdawacz.rozdaj(los, reka);
+		int lewy = ocenaLew(reka, kontrakt.atut);
+		int wpadki = ILOSC_LEW - lewy;
+		bool rozgrywajacyWygral = lewy >= kontrakt.lwy + DOMYSLNE_LEWY;
+		punktyA.clear();
+		punktyB.clear();
+		punkty(punktyA, punktyB, kontrakt.lwy, kontrakt.atut, kontrakt.kontra, kontrakt.rekontra,
+		kontrakt.poPartii, A_ID, rozgrywajacyWygral, wpadki, cisza);
+		wynik.rozdan++;
+		wynik.wygranych += rozgrywajacyWygral;
+		wynik.sumaPunktow += punktyA.back() - punktyB.back();
+		wynik.lewy[lewy]++;
+	}
+}
+
+WynikSymulacji symuluj(const Reka *znane, const Kontrakt kontrakt, const long long ileRozdan, unsigned int watki, const uint64_t ziarno)
+{
+	if(watki == 0) watki = 1;
+	Rozdawacz rozdawacz(znane);
+	std::vector <WynikSymulacji> wyniki(watki);
+	std::vector <std::thread> pula;
+	for(unsigned int i = 0; i < watki; i++)
+	{
+		long long porcja = ileRozdan / watki + (i < ileRozdan % watki);
+		pula.emplace_back(symulujWatek, rozdawacz, kontrakt, porcja, ziarno + i * 0x9e3779b97f4a7c15ULL, std::ref(wyniki[i]));
+	}
+	WynikSymulacji suma;
+	for(unsigned int i = 0; i < watki; i++)
+	{
+		pula[i].join();
+		suma.dodaj(wyniki[i]);
+	}
+	return suma;
+}
+
+// Cala liczba z przedzialu [minimum, maksimum], bez smieci na koncu.
+template <typename Liczba>
+bool wczytajLiczbe(const char *tekst, Liczba &wartosc, const Liczba minimum, const Liczba maksimum)
+{
+	const char *koniec = tekst + std::strlen(tekst);
+	std::from_chars_result wynik = std::from_chars(tekst, koniec, wartosc);
+	return wynik.ec == std::errc() && wynik.ptr == koniec && wartosc >= minimum && wartosc <= maksimum;
+}
+
+void uzycie()
+{
+	print("Uzycie: symulacja <reka N> <reka S lub -> <lwy 1-7> <atut 1-5> [po partii 0-3] [kontra 0-2] [rozdan] [watkow 1-256]");
+	print("Reka w zapisie PBN, np. AKQ2.KJ3.T98.A32 (piki.kiery.kara.trefle)");
+	print("Atut: 1 - BA, 2 - Trefl, 3 - Karo, 4 - Kier, 5 - Pik; po partii jak w tabeli: 0 - Nikt, 1 - My, 2 - Oni, 3 - Obaj");
+}
+
+int main(int argc, char **argv)
+{
+	if(argc < 5)
+	{
+		uzycie();
+		return 1;
+	}
+	Reka znane[ILOSC_REK] = {};
+	if(!wczytajReke(argv[1], znane[N_ID]) || argv[1] == std::string("-") || !wczytajReke(argv[2], znane[S_ID]) || (znane[N_ID] & znane[S_ID]))
+	{
+		print("Niepoprawna reka!");
+		uzycie();
+		return 1;
+	}
+	Kontrakt kontrakt;
+	kontrakt.poPartii = 0;
+	int kontra = 0;
+	long long ileRozdan = DOMYSLNA_ILOSC_ROZDAN;
+	unsigned int watki = std::thread::hardware_concurrency();
+	if(!wczytajLiczbe(argv[3], kontrakt.lwy, MINIMALNY_LEW, MAKSYMALNY_LEW) || !wczytajLiczbe(argv[4], kontrakt.atut, 1, 5)
+	|| (argc > 5 && !wczytajLiczbe(argv[5], kontrakt.poPartii, 0, 3)) || (argc > 6 && !wczytajLiczbe(argv[6], kontra, 0, 2))
+	|| (argc > 7 && !wczytajLiczbe(argv[7], ileRozdan, 1LL, (long long)INT64_MAX))
+	|| (argc > 8 && !wczytajLiczbe(argv[8], watki, 1u, MAKSYMALNIE_WATKOW)))
+	{
+		uzycie();
+		return 1;
+	}
+	kontrakt.kontra = kontra >= 1;
+	kontrakt.rekontra = kontra >= 2;
+	// Watek bez ani jednego rozdania nie ma nic do roboty.
+	if(watki == 0) watki = 1;
+	if((long long)watki > ileRozdan) watki = (unsigned int)ileRozdan;
+
+	lwyAtut(kontrakt.lwy, kontrakt.atut);
+	uint64_t ziarno = (uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+	auto start = std::chrono::steady_clock::now();
+	WynikSymulacji wynik = symuluj(znane, kontrakt, ileRozdan, watki, ziarno);
+	double sekundy = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "Rozdan: " << wynik.rozdan << " w " << sekundy << " s (" << (long long)(wynik.rozdan / sekundy) << " rozdan/s)" << std::endl;
+	std::cout << "Szansa wygrania kontraktu: " << 100.0 * wynik.wygranych / wynik.rozdan << "%" << std::endl;
+	std::cout << "Srednio punktow dla rozgrywajacego: " << (double)wynik.sumaPunktow / wynik.rozdan << std::endl;
+	print("Lewy    Rozdania");
+	for(int i = 0; i <= ILOSC_LEW; i++)
+	{
+		if(wynik.lewy[i]) std::cout << i << "       " << 100.0 * wynik.lewy[i] / wynik.rozdan << "%" << std::endl;
+	}
+	return 0;
+}
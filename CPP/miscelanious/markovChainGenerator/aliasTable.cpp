@@ -0,0 +1,164 @@
+#ifndef ALIAS_TABLE_CPP
+#define ALIAS_TABLE_CPP
+
+// Vose alias tables for every context of an ngramTrie, plus the context
+// each successor leads to, so generating a word is two random numbers and
+// a handful of array reads no matter how many successors a context has.
+
+#include <cstdint>
+#include <vector>
+#include "ngramTrie.cpp"
+#include "fastRandom.cpp"
+
+const uint32_t ALWAYS_COLUMN = UINT32_MAX;
+
+// Work space reused from one alias table to the next.
+struct aliasScratch
+{
+	std::vector <uint64_t> weight;
+	std::vector <uint32_t> small;
+	std::vector <uint32_t> large;
+};
+
+// Column j of a table with n entries is kept with probability
+// threshold[j] / 2^32, otherwise alias[j] is taken. Integer weights
+// count(j) * n against the target total keep the split exact.
+template <typename Count>
+void buildAlias(const uint32_t n, Count count, uint32_t *threshold, uint32_t *alias, aliasScratch &scratch)
+{
+	std::vector <uint64_t> &weight = scratch.weight;
+	std::vector <uint32_t> &small = scratch.small;
+	std::vector <uint32_t> &large = scratch.large;
+	uint64_t total = 0;
+	weight.resize(n);
+	small.clear();
+	large.clear();
+	for(uint32_t j = 0; j < n; j++)
+	{
+		weight[j] = (uint64_t)count(j) * n;
+		total += count(j);
+	}
+	for(uint32_t j = 0; j < n; j++)
+	{
+		if(weight[j] < total) small.push_back(j);
+		else large.push_back(j);
+	}
+	while(!small.empty() && !large.empty())
+	{
+		uint32_t less = small.back();
+		uint32_t more = large.back();
+		small.pop_back();
+		threshold[less] = (uint32_t)((double)weight[less] / (double)total * 4294967296.0);
+		alias[less] = more;
+		weight[more] -= total - weight[less];
+		if(weight[more] < total)
+		{
+			large.pop_back();
+			small.push_back(more);
+		}
+	}
+	// Whatever is left is full up to rounding.
+	for(uint32_t j : small)
+	{
+		threshold[j] = ALWAYS_COLUMN;
+		alias[j] = j;
+	}
+	for(uint32_t j : large)
+	{
+		threshold[j] = ALWAYS_COLUMN;
+		alias[j] = j;
+	}
+}
+
+// Draws an entry of an alias table with n entries from one random word.
+uint32_t sampleAlias(const uint64_t bits, const uint32_t n, const uint32_t *threshold, const uint32_t *alias)
+{
+	uint32_t column = (uint32_t)(((bits >> 32) * n) >> 32);
+	return (uint32_t)bits < threshold[column] ? column : alias[column];
+}
+
+void buildAliasTables(ngramTrie &trie)
+{
+	const packedArray &contexts = trie.children[trie.order - 1];
+	std::vector <uint32_t> threshold(trie.successorCount());
+	std::vector <uint32_t> alias(trie.successorCount());
+	aliasScratch scratch;
+	for(uint64_t context = 0; context + 1 < contexts.size(); context++)
+	{
+		uint64_t begin = contexts.get(context);
+		buildAlias((uint32_t)(contexts.get(context + 1) - begin), [&](const uint32_t j) { return trie.counts.get(begin + j); },
+			threshold.data() + begin, alias.data() + begin, scratch);
+	}
+	trie.threshold = packValues(threshold);
+	trie.alias = packValues(alias);
+}
+
+void linkContextsBelow(ngramTrie &trie, const uint32_t level, const uint64_t begin, const uint64_t end, std::vector <uint32_t> &context,
+	std::vector <uint32_t> &next)
+{
+	for(uint64_t i = begin; i < end; i++)
+	{
+		context[level] = (uint32_t)trie.words[level].get(i);
+		uint64_t childBegin = trie.children[level].get(i);
+		uint64_t childEnd = trie.children[level].get(i + 1);
+		if(level + 1 < trie.order)
+		{
+			linkContextsBelow(trie, level + 1, childBegin, childEnd, context, next);
+			continue;
+		}
+		for(uint64_t leaf = childBegin; leaf < childEnd; leaf++)
+		{
+			context[trie.order] = (uint32_t)trie.words[trie.order].get(leaf);
+			uint64_t following = 0;
+			next[leaf] = trie.findContext(context.data() + 1, following) ? (uint32_t)following : (uint32_t)trie.contextCount();
+		}
+	}
+}
+
+// The context after emitting successor `leaf` is the old context shifted
+// by one word. It is looked up once here instead of on every draw; a
+// context that never occurred in the corpus is stored as contextCount().
+void linkContexts(ngramTrie &trie)
+{
+	std::vector <uint32_t> context(trie.order + 1);
+	std::vector <uint32_t> next(trie.successorCount());
+	linkContextsBelow(trie, 0, 0, trie.words[0].size(), context, next);
+	trie.nextContext = packValues(next);
+}
+
+void prepareGeneration(ngramTrie &trie)
+{
+	buildAliasTables(trie);
+	linkContexts(trie);
+}
+
+uint64_t sampleSuccessor(const ngramTrie &trie, const uint64_t context, xoshiro256 &random)
+{
+	const packedArray &contexts = trie.children[trie.order - 1];
+	uint64_t begin = contexts.get(context);
+	uint32_t n = (uint32_t)(contexts.get(context + 1) - begin);
+	uint64_t bits = random();
+	uint64_t column = ((bits >> 32) * n) >> 32;
+	if((uint32_t)bits < trie.threshold.get(begin + column)) return begin + column;
+	return begin + trie.alias.get(begin + column);
+}
+
+// Fills out with word ids; whenever the chain walks into a context the
+// corpus never continued it jumps to a random one. Returns how many words it
+// wrote: count, or 0 for a model with nothing to continue.
+std::size_t generateWords(const ngramTrie &trie, xoshiro256 &random, uint32_t *out, const std::size_t count)
+{
+	const uint32_t contexts = (uint32_t)trie.contextCount();
+	if(contexts == 0) return 0;
+	uint64_t context = random.below(contexts);
+	for(std::size_t i = 0; i < count; i++)
+	{
+		uint64_t leaf = sampleSuccessor(trie, context, random);
+		out[i] = (uint32_t)trie.words[trie.order].get(leaf);
+		context = trie.nextContext.get(leaf);
+		if(context == contexts) context = random.below(contexts);
+	}
+	return count;
+}
+
+#endif
@@ -0,0 +1,161 @@
+// Throughput of every stage of the word model on synthetic corpora of
+// 1 MB up to 1 GB: tokenizing, training, loading a saved model and
+// generating. Word frequencies follow Zipf's law like real text does.
+// Every corpus size runs in a forked child so its peak RSS, read back with
+// getrusage, belongs to that size alone. Results are printed as JSON.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "shardedTraining.cpp"
+#include "modelFile.cpp"
+
+const std::size_t MEGABYTE = 1 << 20;
+const std::size_t DEFAULT_MAX_MEGABYTES = 1024;
+const uint32_t ZIPF_VOCABULARY = 100000;
+const uint32_t WORDS_PER_LINE = 16;
+const std::size_t GENERATED_WORDS = 10000000;
+
+double secondsSince(const std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+}
+
+std::string randomWord(xoshiro256 &random)
+{
+	std::string word(3 + random.below(8), 'a');
+	for(std::size_t i = 0; i < word.size(); i++) word[i] = (char)('a' + random.below(26));
+	return word;
+}
+
+// Writes `bytes` of text whose word ranks follow Zipf's law with exponent 1.
+bool writeZipfCorpus(const char *path, const std::size_t bytes, const uint64_t seed)
+{
+	xoshiro256 random(seed);
+	std::vector <std::string> words(ZIPF_VOCABULARY);
+	for(uint32_t rank = 0; rank < ZIPF_VOCABULARY; rank++) words[rank] = randomWord(random);
+	std::vector <uint32_t> threshold(ZIPF_VOCABULARY);
+	std::vector <uint32_t> alias(ZIPF_VOCABULARY);
+	aliasScratch scratch;
+	buildAlias(ZIPF_VOCABULARY, [](const uint32_t rank) { return (uint32_t)(1000000000u / (rank + 1)); }, threshold.data(), alias.data(), scratch);
+
+	FILE *file = std::fopen(path, "wb");
+	if(file == nullptr) return false;
+	std::string buffer;
+	std::size_t written = 0;
+	uint32_t onLine = 0;
+	while(written < bytes)
+	{
+		const std::string &word = words[sampleAlias(random(), ZIPF_VOCABULARY, threshold.data(), alias.data())];
+		buffer += word;
+		buffer += ++onLine % WORDS_PER_LINE == 0 ? '\n' : ' ';
+		if(buffer.size() >= MEGABYTE || written + buffer.size() >= bytes)
+		{
+			std::size_t chunk = written + buffer.size() > bytes ? bytes - written : buffer.size();
+			std::fwrite(buffer.data(), 1, chunk, file);
+			written += chunk;
+			buffer.clear();
+		}
+	}
+	return std::fclose(file) == 0;
+}
+
+// Runs every stage on one corpus size and returns its JSON fields.
+std::string measureCorpus(const std::size_t bytes, const uint32_t order, const unsigned int threads)
+{
+	std::ostringstream json;
+	std::string corpusPath = "/tmp/markovBenchmark" + std::to_string(getpid()) + ".txt";
+	std::string modelPath = "/tmp/markovBenchmark" + std::to_string(getpid()) + ".model";
+	if(!writeZipfCorpus(corpusPath.c_str(), bytes, bytes)) return "\"error\": \"could not write corpus\"";
+	mappedFile corpus;
+	corpus.open(corpusPath.c_str());
+
+	auto start = std::chrono::steady_clock::now();
+	uint64_t tokens = 0;
+	tokenize(corpus.view(), [&](const std::string_view) { tokens++; });
+	double tokenizeSeconds = secondsSince(start);
+
+	vocabulary words;
+	uint64_t seen = 0;
+	start = std::chrono::steady_clock::now();
+	ngramTrie trie = trainSharded(corpus.view(), order, threads, words, seen);
+	double trainSeconds = secondsSince(start);
+	prepareGeneration(trie);
+	saveModel(modelPath.c_str(), trie, makeWordTable(words));
+
+	markovModel model;
+	start = std::chrono::steady_clock::now();
+	bool loaded = loadModel(modelPath.c_str(), model);
+	double loadSeconds = secondsSince(start);
+
+	std::vector <uint32_t> text(GENERATED_WORDS);
+	xoshiro256 random(bytes);
+	start = std::chrono::steady_clock::now();
+	std::size_t generated = loaded ? generateWords(model.trie, random, text.data(), text.size()) : 0;
+	double generateSeconds = secondsSince(start);
+
+	json << "\"corpusBytes\": " << bytes << ", \"words\": " << tokens
+	<< ", \"tokenizeSeconds\": " << tokenizeSeconds << ", \"tokenizeMBPerSecond\": " << bytes / MEGABYTE / tokenizeSeconds
+	<< ", \"trainSeconds\": " << trainSeconds << ", \"trainWordsPerSecond\": " << seen / trainSeconds
+	<< ", \"vocabulary\": " << words.size() << ", \"ngrams\": " << trie.successorCount() << ", \"modelBytes\": " << model.file.size
+	<< ", \"loadMilliseconds\": " << loadSeconds * 1000 << ", \"generatedWords\": " << generated
+	<< ", \"generateWordsPerSecond\": " << generated / generateSeconds;
+	std::remove(corpusPath.c_str());
+	std::remove(modelPath.c_str());
+	return json.str();
+}
+
+// Forks a child for one size; the child sends its fields through a pipe
+// and the parent adds the child's peak RSS.
+std::string runChild(const std::size_t bytes, const uint32_t order, const unsigned int threads)
+{
+	int channel[2];
+	if(pipe(channel) != 0) return "{\"corpusBytes\": " + std::to_string(bytes) + ", \"error\": \"pipe failed\"}";
+	pid_t child = fork();
+	if(child == 0)
+	{
+		close(channel[0]);
+		std::string fields = measureCorpus(bytes, order, threads);
+		bool sent = write(channel[1], fields.data(), fields.size()) == (ssize_t)fields.size();
+		close(channel[1]);
+		_exit(sent ? 0 : 1);
+	}
+	close(channel[1]);
+	std::string fields;
+	char buffer[4096];
+	ssize_t got;
+	while((got = read(channel[0], buffer, sizeof(buffer))) > 0) fields.append(buffer, (std::size_t)got);
+	close(channel[0]);
+	int status = 0;
+	struct rusage usage;
+	wait4(child, &status, 0, &usage);
+	if(fields.empty()) fields = "\"corpusBytes\": " + std::to_string(bytes) + ", \"error\": \"child failed\"";
+	return "{" + fields + ", \"peakRssKB\": " + std::to_string(usage.ru_maxrss) + "}";
+}
+
+int main(int argc, char **argv)
+{
+	std::size_t maxMegabytes = argc > 1 ? std::stoull(argv[1]) : DEFAULT_MAX_MEGABYTES;
+	uint32_t order = argc > 2 ? (uint32_t)std::stoul(argv[2]) : 2;
+	unsigned int threads = argc > 3 ? (unsigned int)std::stoul(argv[3]) : std::thread::hardware_concurrency();
+	if(order < 1 || order > MAX_ORDER)
+	{
+		std::cout << "Usage: benchmark [max corpus MB] [order 1-" << MAX_ORDER << "] [threads]" << std::endl;
+		return 1;
+	}
+	std::cout << "{\"order\": " << order << ", \"threads\": " << threads << ", \"results\": [" << std::endl;
+	for(std::size_t megabytes = 1; megabytes <= maxMegabytes; megabytes *= 4)
+	{
+		std::cerr << "Corpus of " << megabytes << " MB" << std::endl;
+		std::cout << (megabytes == 1 ? "  " : ",\n  ") << runChild(megabytes * MEGABYTE, order, threads) << std::flush;
+	}
+	std::cout << "\n]}" << std::endl;
+	return 0;
+}
@@ -0,0 +1,136 @@
+#ifndef CHAR_MODEL_CPP
+#define CHAR_MODEL_CPP
+
+// Character-level Markov model for generating names and made-up words.
+// There are only 27 symbols: 0 marks the start and end of a word and
+// 1 - 26 are the letters a - z, everything else being dropped. An order-k
+// context is then a number below 27^k, so the counts live in one dense
+// array indexed by context and symbol instead of any hash or trie.
+//
+// For generation every context gets a cumulative table of its counts
+// padded to CHAR_TABLE_WIDTH entries with the total. The symbol for a
+// uniform r below the total is the number of entries <= r, found by
+// comparing all 32 entries with r at once.
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "fastRandom.cpp"
+#include "tokenizer.cpp"
+
+const uint32_t CHAR_SYMBOLS = 27;
+const uint32_t CHAR_TABLE_WIDTH = 32;
+const uint32_t MAX_CHAR_ORDER = 4;
+const uint32_t WORD_BOUNDARY = 0;
+const std::size_t MAX_CHAR_WORD_LENGTH = 64;
+
+// Letter symbol of a byte, WORD_BOUNDARY for anything but a - z / A - Z.
+uint32_t charSymbol(const unsigned char c)
+{
+	unsigned char lower = c | 0x20;
+	return lower >= 'a' && lower <= 'z' ? (uint32_t)(lower - 'a' + 1) : WORD_BOUNDARY;
+}
+
+struct charModel
+{
+	uint32_t order;
+	uint32_t contexts;
+	std::vector <uint32_t> counts;
+	std::vector <uint32_t> cumulative;
+
+	explicit charModel(const uint32_t contextLength) : order(contextLength), contexts(1)
+	{
+		for(uint32_t i = 0; i < order; i++) contexts *= CHAR_SYMBOLS;
+		counts.assign((std::size_t)contexts * CHAR_SYMBOLS, 0);
+	}
+
+	// Drops the oldest symbol of the context and appends `symbol`.
+	uint32_t advance(const uint32_t context, const uint32_t symbol) const { return (context * CHAR_SYMBOLS + symbol) % contexts; }
+
+	// Counts the letters of one word; the context starts as all boundaries.
+	void addWord(const std::string_view word)
+	{
+		uint32_t context = 0;
+		bool letters = false;
+		for(std::size_t i = 0; i < word.size(); i++)
+		{
+			uint32_t symbol = charSymbol((unsigned char)word[i]);
+			if(symbol == WORD_BOUNDARY) continue;
+			counts[(std::size_t)context * CHAR_SYMBOLS + symbol]++;
+			context = advance(context, symbol);
+			letters = true;
+		}
+		if(letters) counts[(std::size_t)context * CHAR_SYMBOLS + WORD_BOUNDARY]++;
+	}
+
+	void train(const std::string_view text)
+	{
+		tokenize(text, [&](const std::string_view word) { addWord(word); });
+	}
+
+	void buildCumulative()
+	{
+		cumulative.assign((std::size_t)contexts * CHAR_TABLE_WIDTH, 0);
+		for(uint32_t context = 0; context < contexts; context++)
+		{
+			uint32_t *table = cumulative.data() + (std::size_t)context * CHAR_TABLE_WIDTH;
+			uint32_t sum = 0;
+			for(uint32_t symbol = 0; symbol < CHAR_SYMBOLS; symbol++)
+			{
+				sum += counts[(std::size_t)context * CHAR_SYMBOLS + symbol];
+				table[symbol] = sum;
+			}
+			for(uint32_t j = CHAR_SYMBOLS; j < CHAR_TABLE_WIDTH; j++) table[j] = sum;
+		}
+	}
+
+	uint32_t total(const uint32_t context) const { return cumulative[(std::size_t)context * CHAR_TABLE_WIDTH + CHAR_TABLE_WIDTH - 1]; }
+};
+
+#ifdef __AVX2__
+// AVX2 has only signed compares, both sides are moved into signed range.
+uint32_t findSymbol(const uint32_t *table, const uint32_t r)
+{
+	const __m256i sign = _mm256_set1_epi32((int)0x80000000u);
+	const __m256i target = _mm256_xor_si256(_mm256_set1_epi32((int)r), sign);
+	uint32_t above = 0;
+	for(uint32_t j = 0; j < CHAR_TABLE_WIDTH; j += 8)
+	{
+		__m256i entries = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(table + j)), sign);
+		above += (uint32_t)__builtin_popcount((unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(entries, target))));
+	}
+	return CHAR_TABLE_WIDTH - above;
+}
+#else
+uint32_t findSymbol(const uint32_t *table, const uint32_t r)
+{
+	uint32_t atMost = 0;
+	for(uint32_t j = 0; j < CHAR_TABLE_WIDTH; j++) atMost += table[j] <= r;
+	return atMost;
+}
+#endif
+
+// Appends one generated word to out, returning its length; 0 if the model
+// has never seen a word. Words are cut at MAX_CHAR_WORD_LENGTH letters.
+std::size_t generateCharWord(const charModel &model, xoshiro256 &random, std::string &out)
+{
+	uint32_t context = 0;
+	std::size_t length = 0;
+	while(length < MAX_CHAR_WORD_LENGTH)
+	{
+		uint32_t total = model.total(context);
+		if(total == 0) return length;
+		uint32_t symbol = findSymbol(model.cumulative.data() + (std::size_t)context * CHAR_TABLE_WIDTH, random.below(total));
+		if(symbol == WORD_BOUNDARY) return length;
+		out += (char)('a' + symbol - 1);
+		context = model.advance(context, symbol);
+		length++;
+	}
+	return length;
+}
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef FAST_RANDOM_CPP
+#define FAST_RANDOM_CPP
+
+#include <cstdint>
+
+uint64_t splitmix64(uint64_t &state)
+{
+	uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+// xoshiro256**, a few times faster than std::mt19937 with a 4-word state.
+struct xoshiro256
+{
+	uint64_t s[4];
+
+	explicit xoshiro256(uint64_t seed)
+	{
+		for(int i = 0; i < 4; i++) s[i] = splitmix64(seed);
+	}
+
+	static uint64_t rotateLeft(const uint64_t x, const int k) { return (x << k) | (x >> (64 - k)); }
+
+	uint64_t operator()()
+	{
+		const uint64_t result = rotateLeft(s[1] * 5, 7) * 9;
+		const uint64_t t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotateLeft(s[3], 45);
+		return result;
+	}
+
+	// Uniform in [0, n) from the top 32 bits, multiply instead of modulo.
+	uint32_t below(const uint32_t n) { return (uint32_t)(((operator()() >> 32) * n) >> 32); }
+};
+
+#endif
@@ -1,137 +1,341 @@
 #ifndef MAIN_CPP
 #define MAIN_CPP
 
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <iostream>
+#include <random>
+#include <thread>
+#include <utility>
 #include <vector>
-#include "basic.cpp"
+#include "tokenizer.cpp"
+#include "shardedTraining.cpp"
+#include "aliasTable.cpp"
+#include "modelFile.cpp"
+#include "onlineModel.cpp"
+#include "charModel.cpp"
 
-struct wordOccurences
+struct wordProbability
 {
-	std::string word;
-	int occurences;
-}
-
-struct previousWords
-{
-	std::string word;
-	std::vector <wordOccurences> previousWords;
+	uint64_t context;
+	uint32_t nextWord;
+	float probability;
 };
 
-struct wordProbabiliy
+// Contexts are numbered by their position on the last context level of
+// the trie, successors by their position on the leaf level.
+std::vector <wordProbability> getWordProbability(const ngramTrie &trie)
 {
-	std::string previousWord;
-	std::string nextWord;
-	float probability;
+	std::vector <wordProbability> probabilityVector;
+	probabilityVector.reserve(trie.successorCount());
+	const packedArray &contexts = trie.children[trie.order - 1];
+	for(uint64_t context = 0; context + 1 < contexts.size(); context++)
+	{
+		uint64_t begin = contexts.get(context);
+		uint64_t end = contexts.get(context + 1);
+		uint64_t total = 0;
+		for(uint64_t i = begin; i < end; i++) total += trie.counts.get(i);
+		for(uint64_t i = begin; i < end; i++)
+		{
+			wordProbability probability;
+			probability.context = context;
+			probability.nextWord = (uint32_t)trie.words[trie.order].get(i);
+			probability.probability = (float)trie.counts.get(i) / (float)total;
+			probabilityVector.push_back(probability);
+		}
+	}
+	return probabilityVector;
 }
 
-bool validInput(const std::string userInput)
+// Words of every context in trie order, joined with spaces.
+void collectContexts(const ngramTrie &trie, const vocabulary &words, const uint32_t level, const uint64_t begin, const uint64_t end,
+	const std::string &prefix, std::vector <std::string> &contexts)
 {
-	if(stringContainsNumbers(userInput)) return 0;
-	return 1;
+	for(uint64_t i = begin; i < end; i++)
+	{
+		std::string context = prefix + (level == 0 ? "" : " ") + std::string(words.word((uint32_t)trie.words[level].get(i)));
+		if(level + 1 == trie.order) contexts.push_back(context);
+		else collectContexts(trie, words, level + 1, trie.children[level].get(i), trie.children[level].get(i + 1), context, contexts);
+	}
 }
 
-std::vector <std::string> divideIntoWords(const std::string userInput)
+void printWordProbabilities(const ngramTrie &trie, const vocabulary &words, const std::vector <wordProbability> &probabilities)
 {
-	std::vector <std::string> words;
-	int inputLength = userInput.length();
-	int wordLength = 0;
-	for(int i = 0; i < inputLength; i++)
+	std::vector <std::string> contexts;
+	collectContexts(trie, words, 0, 0, trie.words[0].size(), "", contexts);
+	for(unsigned int i = 0; i < probabilities.size(); i++)
 	{
-		if(userInput.at(i) == ' ')
-		{
-			words.push_back(userInput.substr(i - wordLength, wordLength));
-			wordLength = 0;
-		}else wordLength++;
-		
-		if(i + 1 == inputLength)
+		if(i == 0 || probabilities[i].context != probabilities[i - 1].context)
 		{
-			words.push_back(userInput.substr(i - wordLength + 1, wordLength + 1));
-			wordLength = 0;
+			std::cout << "The words are \"" << contexts[probabilities[i].context] << "\" Words after them are: " << std::endl;
 		}
+		std::cout << words.word(probabilities[i].nextWord) << " " << probabilities[i].probability << std::endl;
 	}
-	return words;
 }
 
-int wordRepeats(const std::vector <previousWords> wordsList, const std::string word)
+// Generates `count` words, timing only the sampling, then prints them.
+// Returns false when the model has no n-grams to generate from.
+bool generateText(const ngramTrie &trie, const wordTable &words, const std::size_t count)
 {
-	int wordsSize = wordsList.size();
-	for(int i = 0; i < wordsSize; i++)
+	xoshiro256 random(((uint64_t)std::random_device{}() << 32) ^ std::random_device{}());
+	std::vector <uint32_t> text(count);
+	auto start = std::chrono::steady_clock::now();
+	std::size_t generated = generateWords(trie, random, text.data(), count);
+	double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+	if(generated == 0)
 	{
-		if(wordsList.at(i).word == word) return i;
+		std::cout << "The model has no n-grams to generate text from" << std::endl;
+		return false;
 	}
-	return -1;
+	std::string output;
+	for(std::size_t i = 0; i < count; i++)
+	{
+		output += words.word(text[i]);
+		output += i + 1 == count ? '\n' : ' ';
+	}
+	std::cout << output;
+	std::cerr << count << " words generated in " << seconds << " s (" << count / seconds << " words/s)" << std::endl;
+	return true;
 }
 
-bool alreadyExists(const std::vector <previousWords> wordsList, const std::string s)
+const char DEFAULT_CORPUS[] = "loremIpsum.txt";
+
+void usage()
 {
-	for(unsigned int i = 0; i < wordsList.size(); i++)
+	std::cout << "Usage:" << std::endl
+	<< "  markov [corpus] [order 1-" << MAX_ORDER << "] [words to generate] [threads]" << std::endl
+	<< "  markov save <corpus> <model file> [order] [threads]" << std::endl
+	<< "  markov load <model file> [words to generate]" << std::endl
+	<< "  markov online <corpus> [order] [batches] [reader threads]" << std::endl
+	<< "  markov names <corpus> [letters of context 1-" << MAX_CHAR_ORDER << "] [names] [min length up to " << MAX_CHAR_WORD_LENGTH << "]" << std::endl;
+}
+
+void printModelSize(const ngramTrie &trie)
+{
+	std::cerr << trie.successorCount() << " n-grams of order " << trie.order << " in " << trie.bytes() << " bytes ("
+	<< (double)trie.bytes() / (trie.successorCount() ? trie.successorCount() : 1) << " bytes per n-gram)" << std::endl;
+}
+
+bool trainModel(const char *corpusPath, const uint32_t order, const unsigned int threads, vocabulary &words, ngramTrie &trie)
+{
+	mappedFile corpus;
+	if(!corpus.open(corpusPath))
 	{
-		if(s == wordsList.previousWOrds
+		std::cout << "Could not open " << corpusPath << std::endl;
+		return false;
 	}
+	uint64_t seen = 0;
+	auto start = std::chrono::steady_clock::now();
+	if(threads <= 1)
+	{
+		markovTrainer trainer(order);
+		tokenize(corpus.view(), [&](const std::string_view word) { trainer.addWord(word); });
+		trie = trainer.finish();
+		words = std::move(trainer.words);
+		seen = trainer.seen;
+	}else trie = trainSharded(corpus.view(), order, threads, words, seen);
+	double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+	std::cerr << "Trained on " << seen << " words (" << corpus.size << " bytes) in " << seconds << " s with "
+	<< (threads <= 1 ? 1 : threads) << " threads, model checksum " << std::hex << modelChecksum(trie, words) << std::dec << std::endl;
+	return true;
 }
 
-std::vector <previousWords> getWordsAndTheirPrevious(const std::vector <std::string> words)
+int saveMode(int argc, char **argv)
 {
-	std::vector <previousWords> wordsList;
-	int wordsSize = words.size();
-	for(int i = 1; i < wordsSize; i++)
-	{
-		previousWords temp;
-		temp.word = words.at(i);
-		wordOccurences tempTwo;
-		tempTwo.word = words.at(i - 1));
-		tempTwo.occurences = 1;
-		temp.previousWords.push_back(tempTwo);
-		int position = wordRepeats(wordsList, temp.word);
-		if(position == -1)
-		{
-			wordsList.push_back(temp);
-		}else
-		{
-			
-			wordsList.at(position).previousWords.push_back(temp.previousWords.at(0));
-		}
+	if(argc < 4)
+	{
+		usage();
+		return 1;
+	}
+	uint32_t order = argc > 4 ? (uint32_t)std::stoul(argv[4]) : 1;
+	unsigned int threads = argc > 5 ? (unsigned int)std::stoul(argv[5]) : std::thread::hardware_concurrency();
+	vocabulary words;
+	ngramTrie trie;
+	if(order < 1 || order > MAX_ORDER)
+	{
+		usage();
+		return 1;
+	}
+	if(!trainModel(argv[2], order, threads, words, trie)) return 1;
+	prepareGeneration(trie);
+	if(!saveModel(argv[3], trie, makeWordTable(words)))
+	{
+		std::cout << "Could not write " << argv[3] << std::endl;
+		return 1;
 	}
-	return wordsList;
+	printModelSize(trie);
+	return 0;
 }
 
-void printPreviousWord(const previousWords word)
+int loadMode(int argc, char **argv)
 {
-	std::cout << "The word is \"" << word.word << "\" Words before it are: " << std::endl;
-	for(unsigned int i = 0; i < word.previousWords.size(); i++)
+	if(argc < 3)
+	{
+		usage();
+		return 1;
+	}
+	std::size_t generate = argc > 3 ? std::stoull(argv[3]) : 0;
+	markovModel model;
+	auto start = std::chrono::steady_clock::now();
+	if(!loadModel(argv[2], model))
 	{
-		print(word.previousWords.at(i));
+		std::cout << argv[2] << " is not a model file of version " << MODEL_VERSION << std::endl;
+		return 1;
 	}
+	double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+	std::cerr << "Loaded " << model.file.size << " bytes in " << seconds * 1000 << " ms" << std::endl;
+	if(generate > 0 && !generateText(model.trie, model.words, generate)) return 1;
+	printModelSize(model.trie);
+	return 0;
 }
 
-
-void printPreviousWordsVector(const std::vector <previousWords> v)
+// Feeds the corpus to an onlineModel batch by batch while reader threads
+// keep generating from it, then checks the result against offline training.
+int onlineMode(int argc, char **argv)
 {
-	for(unsigned int i = 0; i < v.size(); i++)
+	if(argc < 3)
+	{
+		usage();
+		return 1;
+	}
+	uint32_t order = argc > 3 ? (uint32_t)std::stoul(argv[3]) : 1;
+	unsigned int batches = argc > 4 ? (unsigned int)std::stoul(argv[4]) : 100;
+	unsigned int readers = argc > 5 ? (unsigned int)std::stoul(argv[5]) : 2;
+	mappedFile corpus;
+	if(order < 1 || order > MAX_ORDER || batches == 0 || readers > MAX_ONLINE_READERS || !corpus.open(argv[2]))
 	{
-		printPreviousWord(v.at(i));		
+		usage();
+		return 1;
 	}
+	onlineModel model(order);
+	std::atomic <bool> done(false);
+	std::vector <uint64_t> generated(readers, 0);
+	std::vector <std::thread> pool;
+	for(unsigned int r = 0; r < readers; r++)
+	{
+		pool.emplace_back([&, r]()
+		{
+			int slot = model.registerReader();
+			xoshiro256 random(r + 1);
+			std::vector <std::string_view> text;
+			while(!done.load())
+			{
+				text.clear();
+				generateOnline(model, slot, random, 1024, text);
+				generated[r] += text.size();
+			}
+			model.unregisterReader(slot);
+		});
+	}
+	std::vector <std::size_t> boundaries = shardBoundaries(corpus.view(), batches);
+	auto start = std::chrono::steady_clock::now();
+	for(unsigned int b = 0; b < batches; b++) model.update(corpus.view().substr(boundaries[b], boundaries[b + 1] - boundaries[b]));
+	double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+	done.store(true);
+	uint64_t total = 0;
+	for(unsigned int r = 0; r < readers; r++)
+	{
+		pool[r].join();
+		total += generated[r];
+	}
+
+	markovTrainer trainer(order);
+	tokenize(corpus.view(), [&](const std::string_view word) { trainer.addWord(word); });
+	int slot = model.registerReader();
+	const onlineSnapshot *snapshot = model.enter(slot);
+	uint64_t successors = 0;
+	for(uint32_t c = 0; c < snapshot->contexts; c++) if(snapshot->table(c) != nullptr) successors += snapshot->table(c)->size;
+	model.leave(slot);
+	std::cerr << batches << " batches in " << seconds << " s, " << model.rebuiltTables() << " context tables rebuilt, "
+	<< total << " words generated meanwhile by " << readers << " readers" << std::endl;
+	std::cerr << successors << " n-grams online, " << trainer.ngrams.used << " offline" << std::endl;
+	return successors == trainer.ngrams.used ? 0 : 1;
 }
 
-std::vector <wordProbability> getWordProbability(const std::vector <previousWords> wordsList)
+// Made-up names from the letters of the corpus words.
+// Words in a row shorter than the minimum length before names mode gives up.
+const std::size_t MAX_NAME_MISSES = 100000;
+
+int namesMode(int argc, char **argv)
 {
-	std::vector <wordProbability> probalityVector;
-	for(unsigned int i = 0; i - 1 < wordsList.size(); i++)
+	if(argc < 3)
 	{
-		pro
+		usage();
+		return 1;
 	}
+	uint32_t order = argc > 3 ? (uint32_t)std::stoul(argv[3]) : 3;
+	std::size_t names = argc > 4 ? std::stoull(argv[4]) : 20;
+	std::size_t minLength = argc > 5 ? std::stoull(argv[5]) : 4;
+	mappedFile corpus;
+	if(order < 1 || order > MAX_CHAR_ORDER || minLength > MAX_CHAR_WORD_LENGTH || !corpus.open(argv[2]))
+	{
+		usage();
+		return 1;
+	}
+	charModel model(order);
+	model.train(corpus.view());
+	model.buildCumulative();
+	if(model.total(0) == 0)
+	{
+		std::cout << argv[2] << " has no letters to learn from" << std::endl;
+		return 1;
+	}
+	xoshiro256 random(((uint64_t)std::random_device{}() << 32) ^ std::random_device{}());
+	std::string output;
+	std::string name;
+	uint64_t letters = 0;
+	auto start = std::chrono::steady_clock::now();
+	std::size_t misses = 0;
+	for(std::size_t generated = 0; generated < names;)
+	{
+		name.clear();
+		if(generateCharWord(model, random, name) < minLength)
+		{
+			if(++misses < MAX_NAME_MISSES) continue;
+			std::cout << output << "The model does not produce names of " << minLength << " letters or more" << std::endl;
+			return 1;
+		}
+		misses = 0;
+		name[0] = (char)(name[0] - 'a' + 'A');
+		output += name;
+		output += '\n';
+		letters += name.size();
+		generated++;
+	}
+	double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+	std::cout << output;
+	std::cerr << names << " names (" << letters << " letters) in " << seconds << " s (" << names / seconds << " names/s)" << std::endl;
+	return 0;
 }
 
-int main()
+int main(int argc, char **argv)
 {
-	std::string userInput;
-	do{
-		getline(std::cin, userInput);
-	}while(!validInput(userInput));
-	std::vector <std::string> words = divideIntoWords(userInput);
-	std::vector <previousWords> prev = getWordsAndTheirPrevious(words);
-	printPreviousWordsVector(prev);
+	if(argc > 1 && std::string(argv[1]) == "names") return namesMode(argc, argv);
+	if(argc > 1 && std::string(argv[1]) == "online") return onlineMode(argc, argv);
+	if(argc > 1 && std::string(argv[1]) == "save") return saveMode(argc, argv);
+	if(argc > 1 && std::string(argv[1]) == "load") return loadMode(argc, argv);
+	const char *corpusPath = argc > 1 ? argv[1] : DEFAULT_CORPUS;
+	uint32_t order = argc > 2 ? (uint32_t)std::stoul(argv[2]) : 1;
+	std::size_t generate = argc > 3 ? std::stoull(argv[3]) : 0;
+	unsigned int threads = argc > 4 ? (unsigned int)std::stoul(argv[4]) : std::thread::hardware_concurrency();
+	if(order < 1 || order > MAX_ORDER)
+	{
+		usage();
+		return 1;
+	}
+	vocabulary words;
+	ngramTrie trie;
+	if(!trainModel(corpusPath, order, threads, words, trie)) return 1;
+	if(generate == 0)
+	{
+		printWordProbabilities(trie, words, getWordProbability(trie));
+	}else
+	{
+		prepareGeneration(trie);
+		if(!generateText(trie, makeWordTable(words), generate)) return 1;
+	}
+	printModelSize(trie);
 	return 0;
 }
 
@@ -0,0 +1,227 @@
+#ifndef MODEL_FILE_CPP
+#define MODEL_FILE_CPP
+
+// Binary model file. Everything generation needs (the words, every level
+// of the trie and the alias tables) is stored exactly as it sits in
+// memory, so loading is one mmap and a pass over the section headers: the
+// packed arrays simply point into the mapping. The pages are shared
+// between every process that maps the same model.
+//
+// Layout, native byte order, every section starting on an 8-byte boundary:
+//   modelHeader
+//   packed arrays: words[0..order], children[0..order - 1], counts,
+//                  threshold, alias, nextContext, word offsets
+//   word bytes
+// A packed array is a packedSection header followed by its 64-bit words,
+// the word bytes are a 64-bit size followed by the bytes, zero padded.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "aliasTable.cpp"
+#include "tokenizer.cpp"
+#include "vocabulary.cpp"
+
+const char MODEL_MAGIC[8] = {'M', 'A', 'R', 'K', 'O', 'V', 'M', 'D'};
+const uint32_t MODEL_VERSION = 1;
+
+struct modelHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t order;
+	uint64_t fileSize;
+	uint64_t wordCount;
+};
+
+struct packedSection
+{
+	uint64_t length;
+	uint32_t width;
+	uint32_t reserved;
+	uint64_t words;
+};
+
+static_assert(sizeof(modelHeader) % 8 == 0 && sizeof(packedSection) % 8 == 0, "sections must stay 8-byte aligned");
+
+// Words by id as offsets into one byte block, the form they take in the
+// model file. Like packedArray it owns its bytes or borrows them.
+struct wordTable
+{
+	packedArray offsets;
+	std::vector <char> storage;
+	const char *bytes = nullptr;
+
+	wordTable() {}
+
+	wordTable(const wordTable &other) : offsets(other.offsets), storage(other.storage),
+		bytes(other.storage.empty() ? other.bytes : storage.data()) {}
+
+	wordTable(wordTable &&other) = default;
+
+	wordTable &operator=(const wordTable &other)
+	{
+		if(this != &other) *this = wordTable(other);
+		return *this;
+	}
+
+	wordTable &operator=(wordTable &&other) = default;
+
+	std::string_view word(const uint32_t id) const
+	{
+		uint64_t begin = offsets.get(id);
+		return std::string_view(bytes + begin, offsets.get(id + 1) - begin);
+	}
+
+	uint32_t size() const { return offsets.size() == 0 ? 0 : (uint32_t)(offsets.size() - 1); }
+
+	uint64_t byteCount() const { return offsets.size() == 0 ? 0 : offsets.get(offsets.size() - 1); }
+};
+
+wordTable makeWordTable(const vocabulary &words)
+{
+	wordTable table;
+	std::vector <uint64_t> offsets(1, 0);
+	for(uint32_t id = 0; id < words.size(); id++)
+	{
+		table.storage.insert(table.storage.end(), words.word(id).begin(), words.word(id).end());
+		offsets.push_back(table.storage.size());
+	}
+	table.offsets = packedArray(offsets.size(), bitsNeeded(offsets.back()));
+	for(std::size_t i = 0; i < offsets.size(); i++) table.offsets.set(i, offsets[i]);
+	table.bytes = table.storage.data();
+	return table;
+}
+
+// A model read from a file; trie and words point into the mapping.
+struct markovModel
+{
+	mappedFile file;
+	ngramTrie trie;
+	wordTable words;
+};
+
+void writePadding(std::ofstream &out, const uint64_t written)
+{
+	const char zeros[8] = {0};
+	out.write(zeros, (std::streamsize)((8 - written % 8) % 8));
+}
+
+void writePacked(std::ofstream &out, const packedArray &array)
+{
+	packedSection section = {array.length, array.width, 0, array.wordCount};
+	out.write((const char *)&section, sizeof(section));
+	out.write((const char *)array.data, (std::streamsize)(array.wordCount * sizeof(uint64_t)));
+}
+
+// Flushes a closed file's data to disk.
+bool syncFile(const char *path)
+{
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0) return false;
+	bool ok = fsync(fd) == 0;
+	::close(fd);
+	return ok;
+}
+
+// The trie must have been prepared for generation. The model is written
+// next to `path` and renamed over it once it is on disk, so a crash or a
+// full disk leaves the old model in place, and processes that still map
+// it keep their pages.
+bool saveModel(const char *path, const ngramTrie &trie, const wordTable &words)
+{
+	std::vector <const packedArray *> arrays;
+	for(std::size_t d = 0; d < trie.words.size(); d++) arrays.push_back(&trie.words[d]);
+	for(std::size_t d = 0; d < trie.children.size(); d++) arrays.push_back(&trie.children[d]);
+	arrays.push_back(&trie.counts);
+	arrays.push_back(&trie.threshold);
+	arrays.push_back(&trie.alias);
+	arrays.push_back(&trie.nextContext);
+	arrays.push_back(&words.offsets);
+
+	uint64_t byteCount = words.byteCount();
+	modelHeader header;
+	std::memcpy(header.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC));
+	header.version = MODEL_VERSION;
+	header.order = trie.order;
+	header.wordCount = words.size();
+	header.fileSize = sizeof(header) + sizeof(uint64_t) + (byteCount + 7) / 8 * 8;
+	for(std::size_t i = 0; i < arrays.size(); i++) header.fileSize += sizeof(packedSection) + arrays[i]->bytes();
+
+	const std::string temporary = std::string(path) + ".tmp";
+	std::ofstream out(temporary, std::ios::binary);
+	out.write((const char *)&header, sizeof(header));
+	for(std::size_t i = 0; i < arrays.size(); i++) writePacked(out, *arrays[i]);
+	out.write((const char *)&byteCount, sizeof(byteCount));
+	out.write(words.bytes, (std::streamsize)byteCount);
+	writePadding(out, byteCount);
+	out.close();
+	if(!out || !syncFile(temporary.c_str()) || std::rename(temporary.c_str(), path) != 0)
+	{
+		std::remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+// Walks the sections of a mapped model, refusing anything that would read
+// past the end of the file. The values inside the arrays are trusted.
+struct sectionReader
+{
+	const char *data;
+	uint64_t size;
+	uint64_t position;
+
+	bool readPacked(packedArray &array)
+	{
+		if(position + sizeof(packedSection) > size) return false;
+		packedSection section;
+		std::memcpy(&section, data + position, sizeof(section));
+		position += sizeof(section);
+		if(section.width == 0 || section.width > 64 || section.words > (size - position) / sizeof(uint64_t)) return false;
+		if(section.words < (section.length * section.width + 63) / 64 + 1) return false;
+		array = packedArray::view((const uint64_t *)(data + position), section.words, section.length, section.width);
+		position += section.words * sizeof(uint64_t);
+		return true;
+	}
+};
+
+bool loadModel(const char *path, markovModel &model)
+{
+	if(!model.file.open(path, MADV_RANDOM) || model.file.size < sizeof(modelHeader)) return false;
+	modelHeader header;
+	std::memcpy(&header, model.file.data, sizeof(header));
+	if(std::memcmp(header.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC)) != 0 || header.version != MODEL_VERSION) return false;
+	if(header.fileSize != model.file.size || header.order < 1 || header.order > MAX_ORDER) return false;
+
+	sectionReader reader = {model.file.data, model.file.size, sizeof(header)};
+	ngramTrie &trie = model.trie;
+	trie.order = header.order;
+	trie.words.assign(header.order + 1, packedArray());
+	trie.children.assign(header.order, packedArray());
+	for(uint32_t d = 0; d <= header.order; d++) if(!reader.readPacked(trie.words[d])) return false;
+	for(uint32_t d = 0; d < header.order; d++) if(!reader.readPacked(trie.children[d])) return false;
+	if(!reader.readPacked(trie.counts) || !reader.readPacked(trie.threshold) || !reader.readPacked(trie.alias)) return false;
+	if(!reader.readPacked(trie.nextContext) || !reader.readPacked(model.words.offsets)) return false;
+	if(model.words.offsets.size() != header.wordCount + 1) return false;
+	for(uint32_t d = 0; d < header.order; d++) if(trie.children[d].size() != trie.words[d].size() + 1) return false;
+	uint64_t successors = trie.successorCount();
+	if(trie.counts.size() != successors || trie.threshold.size() != successors) return false;
+	if(trie.alias.size() != successors || trie.nextContext.size() != successors) return false;
+
+	uint64_t byteCount;
+	if(reader.position + sizeof(byteCount) > reader.size) return false;
+	std::memcpy(&byteCount, reader.data + reader.position, sizeof(byteCount));
+	reader.position += sizeof(byteCount);
+	if(byteCount > reader.size - reader.position || model.words.byteCount() != byteCount) return false;
+	model.words.bytes = reader.data + reader.position;
+	return true;
+}
+
+#endif
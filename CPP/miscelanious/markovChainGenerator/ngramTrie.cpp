@@ -0,0 +1,69 @@
+#ifndef NGRAM_TRIE_CPP
+#define NGRAM_TRIE_CPP
+
+#include <cstdint>
+#include <vector>
+#include "packedArray.cpp"
+
+// Every n-gram of an order-N model (N context words plus the word that
+// followed them) as a trie over sorted word ids. Level d holds the
+// distinct prefixes of length d + 1; the children of entry i of level d
+// are entries children[d][i] .. children[d][i + 1] of level d + 1, sorted
+// by word id, so finding a context is one binary search per word. The last
+// level holds the successors themselves with their counts. Every array is
+// bit-packed to the width of its largest value, which leaves a few bytes
+// per n-gram.
+//
+// Contexts are numbered by their position on level order - 1. Once
+// aliasTable.cpp has prepared the trie for generation every successor
+// also has its alias table column (threshold, alias) and the number of the
+// context it leads to (nextContext).
+struct ngramTrie
+{
+	uint32_t order = 0;
+	std::vector <packedArray> words;
+	std::vector <packedArray> children;
+	packedArray counts;
+	packedArray threshold;
+	packedArray alias;
+	packedArray nextContext;
+
+	uint64_t successorCount() const { return words.empty() ? 0 : words[order].size(); }
+
+	uint64_t contextCount() const { return words.empty() ? 0 : words[order - 1].size(); }
+
+	// Finds the number of the context made of the `order` ids; false if it
+	// never occurred.
+	bool findContext(const uint32_t *context, uint64_t &index) const
+	{
+		uint64_t begin = 0;
+		uint64_t end = words.empty() ? 0 : words[0].size();
+		for(uint32_t d = 0; d < order; d++)
+		{
+			index = lowerBound(words[d], begin, end, context[d]);
+			if(index == end || words[d].get(index) != context[d]) return false;
+			begin = children[d].get(index);
+			end = children[d].get(index + 1);
+		}
+		return true;
+	}
+
+	bool findSuccessors(const uint32_t *context, uint64_t &begin, uint64_t &end) const
+	{
+		uint64_t index;
+		if(!findContext(context, index)) return false;
+		begin = children[order - 1].get(index);
+		end = children[order - 1].get(index + 1);
+		return true;
+	}
+
+	std::size_t bytes() const
+	{
+		std::size_t total = counts.bytes() + alias.bytes() + nextContext.bytes() + threshold.bytes();
+		for(std::size_t d = 0; d < words.size(); d++) total += words[d].bytes();
+		for(std::size_t d = 0; d < children.size(); d++) total += children[d].bytes();
+		return total;
+	}
+};
+
+#endif
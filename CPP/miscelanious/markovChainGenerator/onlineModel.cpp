@@ -0,0 +1,349 @@
+#ifndef ONLINE_MODEL_CPP
+#define ONLINE_MODEL_CPP
+
+// A model that keeps learning while other threads generate from it.
+//
+// The writer keeps the counts in plain writer-only structures. After every
+// batch it rebuilds the alias table of each context whose counts changed,
+// and only those, as a new immutable contextTable. The tables are reached
+// through pages of ONLINE_PAGE_SIZE pointers, copied on write, and the
+// pages through an immutable snapshot that is swapped in with one atomic
+// store. Readers never lock: they load the snapshot and follow pointers.
+//
+// Replaced tables, pages and snapshots are freed with epoch-based
+// reclamation. A reader announces the global epoch in its slot before
+// loading the snapshot and clears the slot when done. Anything retired at
+// epoch e is freed once every busy slot shows an epoch after e. The slot
+// store and the snapshot load are sequentially consistent, which is what
+// makes a reader that missed the epoch bump see the new snapshot.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "aliasTable.cpp"
+#include "fastRandom.cpp"
+#include "tokenizer.cpp"
+#include "transitionTable.cpp"
+
+const uint32_t ONLINE_PAGE_SIZE = 256;
+const uint32_t MAX_ONLINE_READERS = 64;
+const uint64_t IDLE_READER = UINT64_MAX;
+
+// Successors of one context with their alias table, in one allocation:
+// next words, the context each of them leads to, thresholds and aliases,
+// `size` entries each.
+struct contextTable
+{
+	uint32_t size;
+	std::vector <uint32_t> columns;
+
+	explicit contextTable(const uint32_t successors) : size(successors), columns((std::size_t)successors * 4) {}
+
+	uint32_t *next() { return columns.data(); }
+	uint32_t *nextContext() { return columns.data() + size; }
+	uint32_t *threshold() { return columns.data() + 2 * (std::size_t)size; }
+	uint32_t *alias() { return columns.data() + 3 * (std::size_t)size; }
+	const uint32_t *next() const { return columns.data(); }
+	const uint32_t *nextContext() const { return columns.data() + size; }
+	const uint32_t *threshold() const { return columns.data() + 2 * (std::size_t)size; }
+	const uint32_t *alias() const { return columns.data() + 3 * (std::size_t)size; }
+};
+
+struct contextPage
+{
+	const contextTable *tables[ONLINE_PAGE_SIZE] = {};
+};
+
+struct wordPage
+{
+	std::string_view words[ONLINE_PAGE_SIZE];
+};
+
+struct onlineSnapshot
+{
+	std::vector <const contextPage *> contextPages;
+	std::vector <wordPage *> wordPages;
+	uint32_t contexts = 0;
+	uint32_t words = 0;
+
+	const contextTable *table(const uint32_t context) const
+	{
+		return contextPages[context / ONLINE_PAGE_SIZE]->tables[context % ONLINE_PAGE_SIZE];
+	}
+
+	std::string_view word(const uint32_t id) const { return wordPages[id / ONLINE_PAGE_SIZE]->words[id % ONLINE_PAGE_SIZE]; }
+};
+
+// Everything a publish replaced, freed once no reader can still see it.
+struct retiredBlock
+{
+	uint64_t epoch;
+	const onlineSnapshot *snapshot;
+	std::vector <const contextPage *> pages;
+	std::vector <const contextTable *> tables;
+};
+
+struct successorCounts
+{
+	std::vector <uint32_t> words;
+	std::vector <uint32_t> counts;
+	bool dirty = false;
+};
+
+class onlineModel
+{
+	public:
+	explicit onlineModel(const uint32_t contextLength) :
+		order(contextLength), contextIds(contextLength), successorIds(2), window(contextLength + 1), current(new onlineSnapshot())
+	{
+		for(uint32_t r = 0; r < MAX_ONLINE_READERS; r++)
+		{
+			readerEpochs[r].store(IDLE_READER);
+			readerTaken[r].store(false);
+		}
+	}
+
+	onlineModel(const onlineModel &) = delete;
+	onlineModel &operator=(const onlineModel &) = delete;
+
+	~onlineModel()
+	{
+		for(std::size_t i = 0; i < retired.size(); i++) freeBlock(retired[i]);
+		const onlineSnapshot *snapshot = current.load();
+		for(std::size_t p = 0; p < snapshot->contextPages.size(); p++)
+		{
+			for(uint32_t i = 0; i < ONLINE_PAGE_SIZE; i++) delete snapshot->contextPages[p]->tables[i];
+			delete snapshot->contextPages[p];
+		}
+		for(std::size_t p = 0; p < wordPages.size(); p++) delete wordPages[p];
+		delete snapshot;
+	}
+
+	// Adds a batch of text, continuing from where the previous batch
+	// stopped, and publishes the result. One writer at a time.
+	void update(const std::string_view text)
+	{
+		std::lock_guard <std::mutex> lock(writer);
+		tokenize(text, [&](const std::string_view word) { addWord(word); });
+		publish();
+	}
+
+	// Claims a reader slot, -1 if all MAX_ONLINE_READERS are taken.
+	int registerReader()
+	{
+		for(uint32_t r = 0; r < MAX_ONLINE_READERS; r++)
+		{
+			bool expected = false;
+			if(readerTaken[r].compare_exchange_strong(expected, true)) return (int)r;
+		}
+		return -1;
+	}
+
+	void unregisterReader(const int slot) { readerTaken[slot].store(false); }
+
+	// The snapshot stays valid until leave() with the same slot.
+	const onlineSnapshot *enter(const int slot)
+	{
+		readerEpochs[slot].store(epoch.load());
+		return current.load();
+	}
+
+	void leave(const int slot) { readerEpochs[slot].store(IDLE_READER, std::memory_order_release); }
+
+	uint64_t publishes() const { return published; }
+
+	uint64_t rebuiltTables() const { return rebuilt; }
+
+	uint64_t pendingReclamation() const { return retired.size(); }
+
+	private:
+	uint32_t order;
+	std::mutex writer;
+	// Readers get string_views into the vocabulary's arena.
+	vocabulary words;
+	std::vector <wordPage *> wordPages;
+	ngramCounts contextIds;
+	std::vector <uint32_t> contextWords;
+	std::vector <successorCounts> successors;
+	// (context, word) -> position in that context's successor list, plus one.
+	ngramCounts successorIds;
+	std::vector <uint32_t> dirty;
+	std::vector <uint32_t> window;
+	uint64_t seen = 0;
+	uint32_t previousContext = 0;
+
+	std::atomic <const onlineSnapshot *> current;
+	std::atomic <uint64_t> epoch{1};
+	std::atomic <uint64_t> readerEpochs[MAX_ONLINE_READERS];
+	std::atomic <bool> readerTaken[MAX_ONLINE_READERS];
+	std::vector <retiredBlock> retired;
+	uint64_t published = 0;
+	uint64_t rebuilt = 0;
+
+	uint32_t internWord(const std::string_view word)
+	{
+		uint32_t known = words.size();
+		uint32_t id = words.intern(word);
+		if(id == known)
+		{
+			if(id % ONLINE_PAGE_SIZE == 0) wordPages.push_back(new wordPage());
+			wordPages.back()->words[id % ONLINE_PAGE_SIZE] = words.word(id);
+		}
+		return id;
+	}
+
+	uint32_t contextOf(const uint32_t *context)
+	{
+		uint32_t stored = contextIds.count(context);
+		if(stored != 0) return stored - 1;
+		uint32_t id = (uint32_t)successors.size();
+		contextIds.add(context, id + 1);
+		contextWords.insert(contextWords.end(), context, context + order);
+		successors.emplace_back();
+		return id;
+	}
+
+	void addWord(const std::string_view word)
+	{
+		std::memmove(window.data(), window.data() + 1, order * sizeof(uint32_t));
+		window[order] = internWord(word);
+		if(++seen < order) return;
+		if(seen > order) addSuccessor(previousContext, window[order]);
+		previousContext = contextOf(window.data() + 1);
+	}
+
+	void addSuccessor(const uint32_t context, const uint32_t word)
+	{
+		successorCounts &list = successors[context];
+		uint32_t key[2] = {context, word};
+		uint32_t stored = successorIds.count(key);
+		if(stored == 0)
+		{
+			list.words.push_back(word);
+			list.counts.push_back(1);
+			successorIds.add(key, (uint32_t)list.words.size());
+		}else list.counts[stored - 1]++;
+		if(!list.dirty)
+		{
+			list.dirty = true;
+			dirty.push_back(context);
+		}
+	}
+
+	const contextTable *buildTable(const uint32_t context, aliasScratch &scratch, std::vector <uint32_t> &shifted)
+	{
+		const successorCounts &list = successors[context];
+		uint32_t n = (uint32_t)list.words.size();
+		contextTable *table = new contextTable(n);
+		std::memcpy(table->next(), list.words.data(), n * sizeof(uint32_t));
+		std::memcpy(shifted.data(), contextWords.data() + (std::size_t)context * order + 1, (order - 1) * sizeof(uint32_t));
+		for(uint32_t j = 0; j < n; j++)
+		{
+			shifted[order - 1] = list.words[j];
+			table->nextContext()[j] = contextIds.count(shifted.data()) - 1;
+		}
+		buildAlias(n, [&](const uint32_t j) { return list.counts[j]; }, table->threshold(), table->alias(), scratch);
+		return table;
+	}
+
+	void publish()
+	{
+		const onlineSnapshot *old = current.load();
+		onlineSnapshot *next = new onlineSnapshot(*old);
+		retiredBlock block = {0, old, {}, {}};
+		aliasScratch scratch;
+		std::vector <uint32_t> shifted(order);
+		next->contexts = (uint32_t)successors.size();
+		next->words = words.size();
+		next->wordPages = wordPages;
+		while(next->contextPages.size() * ONLINE_PAGE_SIZE < next->contexts) next->contextPages.push_back(nullptr);
+		// Pages this publish already copied; any other page is shared with
+		// the old snapshot and has to be copied before it changes.
+		std::vector <bool> copied(next->contextPages.size(), false);
+		for(std::size_t i = 0; i < dirty.size(); i++)
+		{
+			uint32_t context = dirty[i];
+			uint32_t page = context / ONLINE_PAGE_SIZE;
+			if(!copied[page])
+			{
+				const contextPage *shared = next->contextPages[page];
+				next->contextPages[page] = shared == nullptr ? new contextPage() : new contextPage(*shared);
+				if(shared != nullptr) block.pages.push_back(shared);
+				copied[page] = true;
+			}
+			contextPage *writable = const_cast <contextPage *> (next->contextPages[page]);
+			const contextTable *&slot = writable->tables[context % ONLINE_PAGE_SIZE];
+			if(slot != nullptr) block.tables.push_back(slot);
+			slot = buildTable(context, scratch, shifted);
+			successors[context].dirty = false;
+			rebuilt++;
+		}
+		// Contexts with no successors yet still need a page to point from.
+		for(std::size_t p = 0; p < next->contextPages.size(); p++) if(next->contextPages[p] == nullptr) next->contextPages[p] = new contextPage();
+		dirty.clear();
+		current.store(next);
+		block.epoch = epoch.fetch_add(1);
+		retired.push_back(block);
+		published++;
+		reclaim();
+	}
+
+	void freeBlock(const retiredBlock &block)
+	{
+		for(std::size_t i = 0; i < block.tables.size(); i++) delete block.tables[i];
+		for(std::size_t i = 0; i < block.pages.size(); i++) delete block.pages[i];
+		delete block.snapshot;
+	}
+
+	void reclaim()
+	{
+		uint64_t oldestReader = IDLE_READER;
+		for(uint32_t r = 0; r < MAX_ONLINE_READERS; r++)
+		{
+			uint64_t readerEpoch = readerEpochs[r].load();
+			if(readerEpoch < oldestReader) oldestReader = readerEpoch;
+		}
+		std::size_t kept = 0;
+		for(std::size_t i = 0; i < retired.size(); i++)
+		{
+			if(retired[i].epoch < oldestReader) freeBlock(retired[i]);
+			else retired[kept++] = retired[i];
+		}
+		retired.resize(kept);
+	}
+};
+
+const uint32_t MAX_CONTEXT_JUMPS = 64;
+
+// Generates up to `count` words from whatever snapshot is current,
+// appending them to out; it gives up early when random jumps keep landing
+// on contexts without successors. The views stay valid as long as the
+// model does.
+void generateOnline(onlineModel &model, const int slot, xoshiro256 &random, const std::size_t count, std::vector <std::string_view> &out)
+{
+	const onlineSnapshot *snapshot = model.enter(slot);
+	uint32_t jumps = 0;
+	uint32_t context = 0;
+	const contextTable *table = nullptr;
+	for(std::size_t i = 0; i < count && snapshot->contexts > 0; i++)
+	{
+		while((table == nullptr || table->size == 0) && jumps < MAX_CONTEXT_JUMPS)
+		{
+			context = random.below(snapshot->contexts);
+			table = snapshot->table(context);
+			jumps++;
+		}
+		if(table == nullptr || table->size == 0) break;
+		uint32_t j = sampleAlias(random(), table->size, table->threshold(), table->alias());
+		out.push_back(snapshot->word(table->next()[j]));
+		context = table->nextContext()[j];
+		table = snapshot->table(context);
+		jumps = 0;
+	}
+	model.leave(slot);
+}
+
+#endif
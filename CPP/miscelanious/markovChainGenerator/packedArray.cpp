@@ -0,0 +1,106 @@
+#ifndef PACKED_ARRAY_CPP
+#define PACKED_ARRAY_CPP
+
+#include <cstdint>
+#include <vector>
+
+// Fixed-width unsigned integers packed back to back into 64-bit words, so
+// an array of ids below 2^17 costs 17 bits per entry instead of 32. One
+// spare word at the end lets get() read a value straddling two words
+// without checking for the end of the array.
+//
+// The words are either owned (bits) or borrowed from somewhere else, a
+// mapped model file for instance; data points at them in both cases.
+struct packedArray
+{
+	std::vector <uint64_t> bits;
+	const uint64_t *data = nullptr;
+	uint64_t wordCount = 0;
+	uint64_t length = 0;
+	uint32_t width = 1;
+	uint64_t mask = 1;
+
+	packedArray() {}
+
+	packedArray(const uint64_t count, const uint32_t bitsPerValue) :
+		bits((count * bitsPerValue + 63) / 64 + 1, 0), data(bits.data()), wordCount(bits.size()), length(count),
+		width(bitsPerValue), mask(bitsPerValue == 64 ? UINT64_MAX : (1ULL << bitsPerValue) - 1) {}
+
+	packedArray(const packedArray &other) : bits(other.bits), data(other.bits.empty() ? other.data : bits.data()),
+		wordCount(other.wordCount), length(other.length), width(other.width), mask(other.mask) {}
+
+	packedArray(packedArray &&other) = default;
+
+	packedArray &operator=(const packedArray &other)
+	{
+		if(this != &other) *this = packedArray(other);
+		return *this;
+	}
+
+	packedArray &operator=(packedArray &&other) = default;
+
+	// Borrows `words` 64-bit words at `borrowed`, which must outlive the array.
+	static packedArray view(const uint64_t *borrowed, const uint64_t words, const uint64_t count, const uint32_t bitsPerValue)
+	{
+		packedArray array;
+		array.data = borrowed;
+		array.wordCount = words;
+		array.length = count;
+		array.width = bitsPerValue;
+		array.mask = bitsPerValue == 64 ? UINT64_MAX : (1ULL << bitsPerValue) - 1;
+		return array;
+	}
+
+	uint64_t get(const uint64_t i) const
+	{
+		uint64_t position = i * width;
+		const uint64_t *word = data + (position >> 6);
+		uint32_t offset = (uint32_t)(position & 63);
+		uint64_t value = word[0] >> offset;
+		if(offset + width > 64) value |= word[1] << (64 - offset);
+		return value & mask;
+	}
+
+	// Only for filling a fresh owned array, the bits being written must still be 0.
+	void set(const uint64_t i, const uint64_t value)
+	{
+		uint64_t position = i * width;
+		uint64_t *word = bits.data() + (position >> 6);
+		uint32_t offset = (uint32_t)(position & 63);
+		word[0] |= value << offset;
+		if(offset + width > 64) word[1] |= value >> (64 - offset);
+	}
+
+	uint64_t size() const { return length; }
+
+	std::size_t bytes() const { return wordCount * sizeof(uint64_t); }
+};
+
+uint32_t bitsNeeded(const uint64_t maxValue)
+{
+	return maxValue == 0 ? 1 : 64 - (uint32_t)__builtin_clzll(maxValue);
+}
+
+packedArray packValues(const std::vector <uint32_t> &values)
+{
+	uint32_t largest = 0;
+	for(std::size_t i = 0; i < values.size(); i++) if(values[i] > largest) largest = values[i];
+	packedArray packed(values.size(), bitsNeeded(largest));
+	for(std::size_t i = 0; i < values.size(); i++) packed.set(i, values[i]);
+	return packed;
+}
+
+// First index in [first, last) whose value is not below `value`, the
+// range being sorted.
+uint64_t lowerBound(const packedArray &array, uint64_t first, uint64_t last, const uint64_t value)
+{
+	while(first < last)
+	{
+		uint64_t middle = first + (last - first) / 2;
+		if(array.get(middle) < value) first = middle + 1;
+		else last = middle;
+	}
+	return first;
+}
+
+#endif
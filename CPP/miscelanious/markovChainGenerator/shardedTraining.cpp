@@ -0,0 +1,182 @@
+#ifndef SHARDED_TRAINING_CPP
+#define SHARDED_TRAINING_CPP
+
+// Training split over threads. The corpus is cut into one shard per thread
+// at line breaks, every shard is trained on its own with shard-local word
+// ids, and the results are merged into exactly the model serial training
+// builds:
+// - the shard vocabularies are merged in shard order, which hands out the
+//   global ids in the same first-occurrence order as serial training,
+// - the n-grams that span a shard boundary, which no shard could see, are
+//   added from each shard's first and last `order` words,
+// - the counts are summed in parallel, each thread owning the n-grams
+//   whose hash falls into its partition, so no two threads touch the same
+//   table.
+
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "tokenizer.cpp"
+#include "transitionTable.cpp"
+
+struct shardTrainer
+{
+	markovTrainer trainer;
+	std::vector <uint32_t> head;
+	std::vector <uint32_t> globalIds;
+	// Translated n-grams and counts for each merge partition.
+	std::vector <std::vector <uint32_t> > partitionKeys;
+	std::vector <std::vector <uint32_t> > partitionCounts;
+
+	explicit shardTrainer(const uint32_t order) : trainer(order) {}
+
+	// The last min(words, order) ids of the shard.
+	const uint32_t *tail() const { return trainer.window.data() + trainer.window.size() - tailLength(); }
+
+	uint32_t tailLength() const { return trainer.seen < trainer.order ? (uint32_t)trainer.seen : trainer.order; }
+};
+
+// Shard boundaries just after a line break near every 1/shards of the
+// text, or after any separator if a line runs on for too long.
+std::vector <std::size_t> shardBoundaries(const std::string_view text, const unsigned int shards)
+{
+	std::vector <std::size_t> boundaries(1, 0);
+	for(unsigned int s = 1; s < shards; s++)
+	{
+		std::size_t position = text.size() / shards * s;
+		if(position < boundaries.back()) position = boundaries.back();
+		std::size_t lineBreak = text.find('\n', position);
+		if(lineBreak != std::string_view::npos && lineBreak - position < text.size() / shards / 2) position = lineBreak;
+		while(position < text.size() && isWordByte((unsigned char)text[position])) position++;
+		boundaries.push_back(position);
+	}
+	boundaries.push_back(text.size());
+	return boundaries;
+}
+
+uint32_t partitionOf(const uint32_t *ids, const uint32_t length, const uint32_t partitions)
+{
+	return (uint32_t)(((hashIds(ids, length) >> 32) * partitions) >> 32);
+}
+
+void trainShard(const std::string_view text, shardTrainer &shard)
+{
+	tokenize(text, [&](const std::string_view word)
+	{
+		shard.trainer.addWord(word);
+		if(shard.head.size() < shard.trainer.order) shard.head.push_back(shard.trainer.window[shard.trainer.order]);
+	});
+}
+
+void translateShard(shardTrainer &shard, const uint32_t partitions)
+{
+	const ngramCounts &ngrams = shard.trainer.ngrams;
+	std::vector <uint32_t> global(ngrams.length);
+	shard.partitionKeys.assign(partitions, std::vector <uint32_t>());
+	shard.partitionCounts.assign(partitions, std::vector <uint32_t>());
+	for(std::size_t slot = 0; slot < ngrams.slots(); slot++)
+	{
+		if(ngrams.counts[slot] == 0) continue;
+		for(uint32_t i = 0; i < ngrams.length; i++) global[i] = shard.globalIds[ngrams.key(slot)[i]];
+		uint32_t partition = partitionOf(global.data(), ngrams.length, partitions);
+		shard.partitionKeys[partition].insert(shard.partitionKeys[partition].end(), global.begin(), global.end());
+		shard.partitionCounts[partition].push_back(ngrams.counts[slot]);
+	}
+	shard.trainer.ngrams = ngramCounts(ngrams.length);
+}
+
+void mergePartition(const std::vector <shardTrainer> &shards, const uint32_t partition, ngramCounts &merged)
+{
+	std::size_t entries = 0;
+	for(std::size_t s = 0; s < shards.size(); s++) entries += shards[s].partitionCounts[partition].size();
+	merged.reserve(entries);
+	for(std::size_t s = 0; s < shards.size(); s++)
+	{
+		const std::vector <uint32_t> &keys = shards[s].partitionKeys[partition];
+		const std::vector <uint32_t> &counts = shards[s].partitionCounts[partition];
+		for(std::size_t i = 0; i < counts.size(); i++) merged.add(keys.data() + i * merged.length, counts[i]);
+	}
+}
+
+// Replays the words around every shard boundary through a window the way
+// markovTrainer would have seen them.
+void addBoundaryNgrams(const std::vector <shardTrainer> &shards, const uint32_t order, std::vector <ngramCounts> &partitions)
+{
+	std::vector <uint32_t> window(order + 1);
+	uint64_t seen = 0;
+	for(std::size_t s = 0; s < shards.size(); s++)
+	{
+		const shardTrainer &shard = shards[s];
+		for(std::size_t i = 0; i < shard.head.size(); i++)
+		{
+			std::memmove(window.data(), window.data() + 1, order * sizeof(uint32_t));
+			window[order] = shard.globalIds[shard.head[i]];
+			if(++seen > order) partitions[partitionOf(window.data(), order + 1, (uint32_t)partitions.size())].add(window.data());
+		}
+		if(shard.trainer.seen <= order) continue;
+		const uint32_t *tail = shard.tail();
+		for(uint32_t i = 0; i < order; i++) window[i + 1] = shard.globalIds[tail[i]];
+		seen += shard.trainer.seen - shard.head.size();
+	}
+}
+
+// Same vocabulary and trie as markovTrainer over the whole text.
+ngramTrie trainSharded(const std::string_view text, const uint32_t order, unsigned int threads, vocabulary &words, uint64_t &seen)
+{
+	if(threads == 0) threads = 1;
+	std::vector <std::size_t> boundaries = shardBoundaries(text, threads);
+	std::vector <shardTrainer> shards;
+	shards.reserve(threads);
+	for(unsigned int s = 0; s < threads; s++) shards.emplace_back(order);
+	std::vector <std::thread> pool;
+	for(unsigned int s = 0; s < threads; s++)
+	{
+		std::string_view shardText = text.substr(boundaries[s], boundaries[s + 1] - boundaries[s]);
+		pool.emplace_back(trainShard, shardText, std::ref(shards[s]));
+	}
+	for(unsigned int s = 0; s < threads; s++) pool[s].join();
+	pool.clear();
+
+	seen = 0;
+	for(unsigned int s = 0; s < threads; s++)
+	{
+		const vocabulary &local = shards[s].trainer.words;
+		shards[s].globalIds.resize(local.size());
+		for(uint32_t id = 0; id < local.size(); id++) shards[s].globalIds[id] = words.intern(local.word(id));
+		seen += shards[s].trainer.seen;
+	}
+
+	for(unsigned int s = 0; s < threads; s++) pool.emplace_back(translateShard, std::ref(shards[s]), threads);
+	for(unsigned int s = 0; s < threads; s++) pool[s].join();
+	pool.clear();
+
+	std::vector <ngramCounts> partitions(threads, ngramCounts(order + 1));
+	for(unsigned int p = 0; p < threads; p++) pool.emplace_back(mergePartition, std::cref(shards), p, std::ref(partitions[p]));
+	for(unsigned int p = 0; p < threads; p++) pool[p].join();
+	addBoundaryNgrams(shards, order, partitions);
+
+	std::vector <const ngramCounts *> tables;
+	for(unsigned int p = 0; p < threads; p++) tables.push_back(&partitions[p]);
+	return buildTrie(tables);
+}
+
+// FNV-1a over the vocabulary and every value of the trie: equal checksums
+// mean an identical model.
+uint64_t modelChecksum(const ngramTrie &trie, const vocabulary &words)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	auto mix = [&](const uint64_t value) { hash = (hash ^ value) * 0x100000001b3ULL; };
+	for(uint32_t id = 0; id < words.size(); id++)
+	{
+		mix(words.word(id).size());
+		for(unsigned char c : words.word(id)) mix(c);
+	}
+	auto mixArray = [&](const packedArray &array) { for(uint64_t i = 0; i < array.size(); i++) mix(array.get(i)); };
+	for(std::size_t d = 0; d < trie.words.size(); d++) mixArray(trie.words[d]);
+	for(std::size_t d = 0; d < trie.children.size(); d++) mixArray(trie.children[d]);
+	mixArray(trie.counts);
+	return hash;
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef TOKENIZER_CPP
+#define TOKENIZER_CPP
+
+// Splits a memory-mapped corpus into words without copying it: every word
+// is handed on as a std::string_view into the mapping. Word bytes are
+// ASCII letters, digits and the apostrophe, plus every byte >= 0x80 so
+// UTF-8 letters stay inside their word; anything else separates words.
+// SSE2 classifies 64 bytes at a time into a bit mask and the word edges
+// are then read off that mask with a count of trailing zeros.
+
+#include <cstdint>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+struct mappedFile
+{
+	const char *data = nullptr;
+	std::size_t size = 0;
+
+	mappedFile() {}
+	mappedFile(const mappedFile &) = delete;
+	mappedFile &operator=(const mappedFile &) = delete;
+
+	~mappedFile() { close(); }
+
+	// An empty file opens fine as an empty mapping. `advice` tells the
+	// kernel how the pages will be read.
+	bool open(const char *path, const int advice = MADV_SEQUENTIAL)
+	{
+		close();
+		int fd = ::open(path, O_RDONLY);
+		if(fd < 0) return false;
+		struct stat status;
+		bool ok = fstat(fd, &status) == 0;
+		if(ok && status.st_size > 0)
+		{
+			void *mapping = mmap(nullptr, (std::size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			ok = mapping != MAP_FAILED;
+			if(ok)
+			{
+				data = (const char *)mapping;
+				size = (std::size_t)status.st_size;
+				madvise(mapping, size, advice);
+			}
+		}
+		::close(fd);
+		return ok;
+	}
+
+	void close()
+	{
+		if(data != nullptr) munmap((void *)data, size);
+		data = nullptr;
+		size = 0;
+	}
+
+	std::string_view view() const { return std::string_view(data, size); }
+};
+
+bool isWordByte(const unsigned char c)
+{
+	return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '\'' || c >= 0x80;
+}
+
+#ifdef __SSE2__
+uint64_t wordMask16(const char *bytes)
+{
+	const __m128i chunk = _mm_loadu_si128((const __m128i *)bytes);
+	const __m128i lower = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+	// Signed compares: bytes >= 0x80 are negative and fail both ranges,
+	// the sign bit itself picks them up in the movemask.
+	__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chunk, _mm_set1_epi8('9' + 1)));
+	__m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+	__m128i apostrophe = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\''));
+	__m128i word = _mm_or_si128(_mm_or_si128(digit, letter), _mm_or_si128(apostrophe, chunk));
+	return (uint64_t)(uint32_t)_mm_movemask_epi8(word);
+}
+
+uint64_t wordMask64(const char *bytes)
+{
+	return wordMask16(bytes) | (wordMask16(bytes + 16) << 16) | (wordMask16(bytes + 32) << 32) | (wordMask16(bytes + 48) << 48);
+}
+#else
+uint64_t wordMask64(const char *bytes)
+{
+	uint64_t mask = 0;
+	for(int i = 0; i < 64; i++) mask |= (uint64_t)isWordByte((unsigned char)bytes[i]) << i;
+	return mask;
+}
+#endif
+
+// Calls onWord(std::string_view) for every word of text, in order.
+template <typename Callback>
+void tokenize(const std::string_view text, Callback &&onWord)
+{
+	const char *data = text.data();
+	const std::size_t size = text.size();
+	std::size_t wordStart = 0;
+	uint64_t inWord = 0;
+	std::size_t block = 0;
+	for(; block + 64 <= size; block += 64)
+	{
+		uint64_t mask = wordMask64(data + block);
+		// A bit is set wherever a byte is on the other side of a word edge
+		// than the byte before it.
+		uint64_t edges = mask ^ ((mask << 1) | inWord);
+		inWord = mask >> 63;
+		while(edges != 0)
+		{
+			std::size_t position = block + (std::size_t)__builtin_ctzll(edges);
+			if(isWordByte((unsigned char)data[position])) wordStart = position;
+			else onWord(std::string_view(data + wordStart, position - wordStart));
+			edges &= edges - 1;
+		}
+	}
+	for(std::size_t i = block; i < size; i++)
+	{
+		uint64_t word = isWordByte((unsigned char)data[i]);
+		if(word && !inWord) wordStart = i;
+		if(!word && inWord) onWord(std::string_view(data + wordStart, i - wordStart));
+		inWord = word;
+	}
+	if(inWord) onWord(std::string_view(data + wordStart, size - wordStart));
+}
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef TRANSITION_TABLE_CPP
+#define TRANSITION_TABLE_CPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "vocabulary.cpp"
+#include "ngramTrie.cpp"
+
+const std::size_t INITIAL_NGRAM_SLOTS = 1024;
+const uint32_t MAX_ORDER = 8;
+
+uint64_t hashKey(uint64_t key)
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	key *= 0xc4ceb9fe1a85ec53ULL;
+	return key ^ (key >> 33);
+}
+
+uint64_t hashIds(const uint32_t *ids, const uint32_t length)
+{
+	uint64_t hash = length;
+	for(uint32_t i = 0; i < length; i++) hash = (hash ^ ids[i]) * 0x9e3779b97f4a7c15ULL;
+	return hashKey(hash);
+}
+
+// Open addressing (linear probing) map from an n-gram, `length` word ids
+// stored side by side in keys[], to the number of times it occurred. A
+// count of 0 marks an empty slot. Every word of the corpus costs one
+// expected O(1) probe.
+struct ngramCounts
+{
+	uint32_t length;
+	std::vector <uint32_t> keys;
+	std::vector <uint32_t> counts;
+	std::size_t used = 0;
+
+	explicit ngramCounts(const uint32_t ngramLength) :
+		length(ngramLength), keys(INITIAL_NGRAM_SLOTS * ngramLength), counts(INITIAL_NGRAM_SLOTS, 0) {}
+
+	std::size_t slots() const { return counts.size(); }
+
+	const uint32_t *key(const std::size_t slot) const { return keys.data() + slot * length; }
+
+	std::size_t findSlot(const uint32_t *ids) const
+	{
+		std::size_t mask = slots() - 1;
+		std::size_t slot = hashIds(ids, length) & mask;
+		while(counts[slot] != 0 && std::memcmp(key(slot), ids, length * sizeof(uint32_t)) != 0) slot = (slot + 1) & mask;
+		return slot;
+	}
+
+	void grow()
+	{
+		std::vector <uint32_t> oldKeys;
+		std::vector <uint32_t> oldCounts;
+		oldKeys.swap(keys);
+		oldCounts.swap(counts);
+		keys.assign(oldKeys.size() * 2, 0);
+		counts.assign(oldCounts.size() * 2, 0);
+		for(std::size_t i = 0; i < oldCounts.size(); i++)
+		{
+			if(oldCounts[i] == 0) continue;
+			std::size_t slot = findSlot(oldKeys.data() + i * length);
+			std::memcpy(keys.data() + slot * length, oldKeys.data() + i * length, length * sizeof(uint32_t));
+			counts[slot] = oldCounts[i];
+		}
+	}
+
+	// Makes room for `entries` n-grams up front. Also keeps the table from
+	// clustering when it is filled in the slot order of another table.
+	void reserve(const std::size_t entries)
+	{
+		while(entries * 4 > slots() * 3) grow();
+	}
+
+	// How often the n-gram was added, 0 if never.
+	uint32_t count(const uint32_t *ids) const { return counts[findSlot(ids)]; }
+
+	void add(const uint32_t *ids, const uint32_t times = 1)
+	{
+		if((used + 1) * 4 > slots() * 3) grow();
+		std::size_t slot = findSlot(ids);
+		if(counts[slot] == 0)
+		{
+			std::memcpy(keys.data() + slot * length, ids, length * sizeof(uint32_t));
+			used++;
+		}
+		counts[slot] += times;
+	}
+};
+
+// Sorts the counted n-grams and lays them out level by level: a new trie
+// entry starts at the first level where an n-gram differs from the
+// previous one. The n-grams may be spread over several tables as long as
+// no two of them hold the same one.
+ngramTrie buildTrie(const std::vector <const ngramCounts *> &tables)
+{
+	const uint32_t length = tables[0]->length;
+	std::vector <std::pair <const uint32_t *, uint32_t> > sorted;
+	std::size_t total = 0;
+	for(std::size_t t = 0; t < tables.size(); t++) total += tables[t]->used;
+	sorted.reserve(total);
+	for(std::size_t t = 0; t < tables.size(); t++)
+	{
+		const ngramCounts &ngrams = *tables[t];
+		for(std::size_t slot = 0; slot < ngrams.slots(); slot++) if(ngrams.counts[slot] != 0) sorted.emplace_back(ngrams.key(slot), ngrams.counts[slot]);
+	}
+	std::sort(sorted.begin(), sorted.end(), [&](const std::pair <const uint32_t *, uint32_t> &a, const std::pair <const uint32_t *, uint32_t> &b)
+	{
+		return std::lexicographical_compare(a.first, a.first + length, b.first, b.first + length);
+	});
+
+	std::vector <std::vector <uint32_t> > words(length);
+	std::vector <std::vector <uint32_t> > children(length - 1);
+	std::vector <uint32_t> counts;
+	counts.reserve(sorted.size());
+	for(std::size_t i = 0; i < sorted.size(); i++)
+	{
+		const uint32_t *ngram = sorted[i].first;
+		uint32_t first = 0;
+		if(i > 0)
+		{
+			const uint32_t *previous = sorted[i - 1].first;
+			while(first < length - 1 && ngram[first] == previous[first]) first++;
+		}
+		for(uint32_t d = first; d < length; d++)
+		{
+			if(d < length - 1) children[d].push_back((uint32_t)words[d + 1].size());
+			words[d].push_back(ngram[d]);
+		}
+		counts.push_back(sorted[i].second);
+	}
+	for(uint32_t d = 0; d + 1 < length; d++) children[d].push_back((uint32_t)words[d + 1].size());
+
+	ngramTrie trie;
+	trie.order = length - 1;
+	for(uint32_t d = 0; d < length; d++) trie.words.push_back(packValues(words[d]));
+	for(uint32_t d = 0; d + 1 < length; d++) trie.children.push_back(packValues(children[d]));
+	trie.counts = packValues(counts);
+	return trie;
+}
+
+// Streams words in, keeping only the last `order` ids between calls.
+struct markovTrainer
+{
+	uint32_t order;
+	vocabulary words;
+	ngramCounts ngrams;
+	std::vector <uint32_t> window;
+	uint64_t seen = 0;
+
+	explicit markovTrainer(const uint32_t contextLength) :
+		order(contextLength), ngrams(contextLength + 1), window(contextLength + 1) {}
+
+	void addWord(const std::string_view word)
+	{
+		std::memmove(window.data(), window.data() + 1, order * sizeof(uint32_t));
+		window[order] = words.intern(word);
+		if(++seen > order) ngrams.add(window.data());
+	}
+
+	ngramTrie finish() const { return buildTrie({&ngrams}); }
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef VOCABULARY_CPP
+#define VOCABULARY_CPP
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+const std::size_t ARENA_CHUNK_SIZE = 1 << 20;
+const std::size_t INITIAL_VOCABULARY_SLOTS = 1024;
+
+// Bump allocator for word bytes. Chunks are never moved or freed before the
+// arena, so a view handed out stays valid for the arena's whole life.
+struct stringArena
+{
+	std::vector <std::unique_ptr <char[]> > chunks;
+	char *cursor = nullptr;
+	std::size_t left = 0;
+	std::size_t allocated = 0;
+
+	std::string_view store(const std::string_view bytes)
+	{
+		if(bytes.size() > left)
+		{
+			// Words longer than a chunk get a chunk of their own.
+			std::size_t size = bytes.size() > ARENA_CHUNK_SIZE ? bytes.size() : ARENA_CHUNK_SIZE;
+			chunks.emplace_back(new char[size]);
+			cursor = chunks.back().get();
+			left = size;
+			allocated += size;
+		}
+		std::memcpy(cursor, bytes.data(), bytes.size());
+		std::string_view stored(cursor, bytes.size());
+		cursor += bytes.size();
+		left -= bytes.size();
+		return stored;
+	}
+};
+
+// Every distinct word gets a dense 32-bit id, in order of first appearance,
+// so the model itself only ever stores ids. Each word is stored once, in
+// the arena; the open addressing table holds id + 1 per slot (0 = empty)
+// and the hash of every word is kept so probes compare hashes before
+// bytes and growing never rehashes a string.
+struct vocabulary
+{
+	stringArena arena;
+	std::vector <std::string_view> words;
+	std::vector <uint64_t> hashes;
+	std::vector <uint32_t> slots;
+
+	vocabulary() : slots(INITIAL_VOCABULARY_SLOTS, 0) {}
+
+	static uint64_t hashWord(const std::string_view word) { return std::hash <std::string_view> {}(word); }
+
+	std::size_t findSlot(const std::string_view word, const uint64_t hash) const
+	{
+		std::size_t mask = slots.size() - 1;
+		std::size_t slot = hash & mask;
+		while(slots[slot] != 0)
+		{
+			uint32_t id = slots[slot] - 1;
+			if(hashes[id] == hash && words[id] == word) break;
+			slot = (slot + 1) & mask;
+		}
+		return slot;
+	}
+
+	void grow()
+	{
+		slots.assign(slots.size() * 2, 0);
+		std::size_t mask = slots.size() - 1;
+		for(uint32_t id = 0; id < words.size(); id++)
+		{
+			std::size_t slot = hashes[id] & mask;
+			while(slots[slot] != 0) slot = (slot + 1) & mask;
+			slots[slot] = id + 1;
+		}
+	}
+
+	uint32_t intern(const std::string_view word)
+	{
+		uint64_t hash = hashWord(word);
+		std::size_t slot = findSlot(word, hash);
+		if(slots[slot] != 0) return slots[slot] - 1;
+		uint32_t id = (uint32_t)words.size();
+		words.push_back(arena.store(word));
+		hashes.push_back(hash);
+		slots[slot] = id + 1;
+		if((words.size() + 1) * 4 > slots.size() * 3) grow();
+		return id;
+	}
+
+	std::string_view word(const uint32_t id) const { return words[id]; }
+
+	uint32_t size() const { return (uint32_t)words.size(); }
+
+	std::size_t bytes() const
+	{
+		return arena.allocated + words.size() * (sizeof(std::string_view) + sizeof(uint64_t)) + slots.size() * sizeof(uint32_t);
+	}
+};
+
+#endif
@@ -0,0 +1,114 @@
+// Samples per second of every sampler in samplers.cpp on one core,
+// std baselines first. The mean of the samples is printed next to each
+// speed as a sanity check and so the work cannot be optimized away.
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "samplers.cpp"
+
+const std::size_t BUFFER_SIZE = 1 << 16;
+const std::size_t DEFAULT_SAMPLES = 1 << 26;
+const int PACKED_PRECISION = 16;
+
+void report(const std::string &name, const std::size_t samples, const double seconds, const double mean)
+{
+    std::cout << std::left << std::setw(32) << name << std::right << std::setw(12) << std::fixed << std::setprecision(1)
+    << samples / seconds / 1e6 << " M/s    mean " << std::setprecision(5) << mean << std::endl;
+}
+
+template <typename Fill>
+void benchmarkBytes(const std::string &name, const std::size_t samples, Fill fill)
+{
+    std::vector <uint8_t> buffer(BUFFER_SIZE);
+    std::size_t ones = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t done = 0; done < samples; done += BUFFER_SIZE)
+    {
+        fill(buffer.data(), BUFFER_SIZE);
+        for(std::size_t i = 0; i < BUFFER_SIZE; i++) ones += buffer[i];
+    }
+    double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+    std::size_t total = (samples + BUFFER_SIZE - 1) / BUFFER_SIZE * BUFFER_SIZE;
+    report(name, total, seconds, (double)ones / total);
+}
+
+template <typename Fill>
+void benchmarkPacked(const std::string &name, const std::size_t samples, Fill fill)
+{
+    std::vector <uint64_t> buffer(BUFFER_SIZE / 64);
+    std::size_t ones = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t done = 0; done < samples; done += BUFFER_SIZE)
+    {
+        fill(buffer.data(), buffer.size());
+        for(std::size_t i = 0; i < buffer.size(); i++) ones += (std::size_t)__builtin_popcountll(buffer[i]);
+    }
+    double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+    std::size_t total = (samples + BUFFER_SIZE - 1) / BUFFER_SIZE * BUFFER_SIZE;
+    report(name, total, seconds, (double)ones / total);
+}
+
+template <typename Value, typename Fill>
+void benchmarkUniform(const std::string &name, const std::size_t samples, Fill fill)
+{
+    std::vector <Value> buffer(BUFFER_SIZE);
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(std::size_t done = 0; done < samples; done += BUFFER_SIZE)
+    {
+        fill(buffer.data(), BUFFER_SIZE);
+        for(std::size_t i = 0; i < BUFFER_SIZE; i++) sum += buffer[i];
+    }
+    double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+    std::size_t total = (samples + BUFFER_SIZE - 1) / BUFFER_SIZE * BUFFER_SIZE;
+    report(name, total, seconds, sum / total);
+}
+
+void benchmarkBernoulli(const double p, const std::size_t samples, const uint64_t seed)
+{
+    std::cout << "Bernoulli p = " << std::defaultfloat << p << std::endl;
+    std::mt19937 mt((uint32_t)seed);
+    std::mt19937_64 mt64(seed);
+    xoshiro256 xoshiro(seed);
+    pcg32 pcg(seed);
+    benchmarkBytes("std mt19937", samples, [&](uint8_t *out, std::size_t n) { bernoulliStd(mt, p, out, n); });
+    benchmarkBytes("std mt19937_64", samples, [&](uint8_t *out, std::size_t n) { bernoulliStd64(mt64, p, out, n); });
+    benchmarkBytes("xoshiro256** threshold", samples, [&](uint8_t *out, std::size_t n) { bernoulliXoshiro(xoshiro, p, out, n); });
+    benchmarkBytes("pcg32 threshold", samples, [&](uint8_t *out, std::size_t n) { bernoulliPcg(pcg, p, out, n); });
+#ifdef __AVX2__
+    xoshiroLanes lanes(seed);
+    benchmarkBytes("xoshiro256+ x4 AVX2", samples, [&](uint8_t *out, std::size_t n) { bernoulliAvx2(lanes, p, out, n); });
+#endif
+    benchmarkPacked("bit-sliced packed (16 bit p)", samples, [&](uint64_t *out, std::size_t n) { bernoulliPacked(xoshiro, p, out, n, PACKED_PRECISION); });
+    if(p == 0.5)
+    {
+        benchmarkBytes("64 bits per draw, unpacked", samples, [&](uint8_t *out, std::size_t n) { bernoulliHalfBits(xoshiro, out, n); });
+        benchmarkPacked("64 bits per draw, packed", samples, [&](uint64_t *out, std::size_t n) { bernoulliHalfPacked(xoshiro, out, n); });
+    }
+}
+
+void benchmarkUniforms(const std::size_t samples, const uint64_t seed)
+{
+    std::cout << "Uniform [0, 1)" << std::endl;
+    std::mt19937 mt((uint32_t)seed);
+    std::mt19937_64 mt64(seed);
+    xoshiro256 xoshiro(seed);
+    pcg32 pcg(seed);
+    benchmarkUniform <double> ("std mt19937 double", samples, [&](double *out, std::size_t n) { uniformStd(mt, out, n); });
+    benchmarkUniform <double> ("std mt19937_64 double", samples, [&](double *out, std::size_t n) { uniformStd64(mt64, out, n); });
+    benchmarkUniform <double> ("xoshiro256** double", samples, [&](double *out, std::size_t n) { uniformXoshiro(xoshiro, out, n); });
+    benchmarkUniform <float> ("pcg32 float", samples, [&](float *out, std::size_t n) { uniformPcg(pcg, out, n); });
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t samples = argc > 1 ? std::stoull(argv[1]) : DEFAULT_SAMPLES;
+    uint64_t seed = ((uint64_t)std::random_device{}() << 32) ^ std::random_device{}();
+    std::cout << samples << " samples per sampler, one core" << std::endl;
+    benchmarkBernoulli(0.5, samples, seed);
+    benchmarkBernoulli(0.3, samples, seed);
+    benchmarkUniforms(samples, seed);
+    return 0;
+}
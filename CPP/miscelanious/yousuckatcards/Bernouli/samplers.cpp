@@ -0,0 +1,223 @@
+#ifndef SAMPLERS_CPP
+#define SAMPLERS_CPP
+
+// Bernoulli and uniform samplers compared by benchmark.cpp. Every sampler
+// fills a whole buffer per call, which is how the games use them and what
+// lets the AVX2 version keep four generators in flight.
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+const int SAMPLER_LANES = 4;
+
+uint64_t splitmix64(uint64_t &state)
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t rotateLeft(const uint64_t x, const int k) { return (x << k) | (x >> (64 - k)); }
+
+struct xoshiro256
+{
+    uint64_t s[4];
+
+    explicit xoshiro256(uint64_t seed)
+    {
+        for(int i = 0; i < 4; i++) s[i] = splitmix64(seed);
+    }
+
+    uint64_t operator()()
+    {
+        const uint64_t result = rotateLeft(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotateLeft(s[3], 45);
+        return result;
+    }
+};
+
+// PCG32 (XSH RR variant), 32 bits per step.
+struct pcg32
+{
+    uint64_t state;
+    uint64_t increment;
+
+    explicit pcg32(uint64_t seed)
+    {
+        state = splitmix64(seed);
+        increment = splitmix64(seed) | 1;
+    }
+
+    uint32_t operator()()
+    {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + increment;
+        uint32_t xorShifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+        uint32_t rotation = (uint32_t)(old >> 59);
+        return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+    }
+};
+
+#ifdef __AVX2__
+// State of four xoshiro256+ generators, one per 64-bit lane of an AVX2
+// register, for bernoulliAvx2.
+struct xoshiroLanes
+{
+    uint64_t s0[SAMPLER_LANES];
+    uint64_t s1[SAMPLER_LANES];
+    uint64_t s2[SAMPLER_LANES];
+    uint64_t s3[SAMPLER_LANES];
+
+    explicit xoshiroLanes(uint64_t seed)
+    {
+        for(int l = 0; l < SAMPLER_LANES; l++)
+        {
+            s0[l] = splitmix64(seed);
+            s1[l] = splitmix64(seed);
+            s2[l] = splitmix64(seed);
+            s3[l] = splitmix64(seed);
+        }
+    }
+};
+#endif
+
+// Probability as a 64-bit threshold: a uniform 64-bit value below it is a success.
+uint64_t probabilityThreshold(const double p)
+{
+    if(p >= 1.0) return UINT64_MAX;
+    if(p <= 0.0) return 0;
+    return (uint64_t)(p * 18446744073709551616.0);
+}
+
+void bernoulliStd(std::mt19937 &generator, const double p, uint8_t *out, const std::size_t count)
+{
+    std::bernoulli_distribution distribution(p);
+    for(std::size_t i = 0; i < count; i++) out[i] = distribution(generator);
+}
+
+void bernoulliStd64(std::mt19937_64 &generator, const double p, uint8_t *out, const std::size_t count)
+{
+    std::bernoulli_distribution distribution(p);
+    for(std::size_t i = 0; i < count; i++) out[i] = distribution(generator);
+}
+
+void bernoulliXoshiro(xoshiro256 &generator, const double p, uint8_t *out, const std::size_t count)
+{
+    const uint64_t threshold = probabilityThreshold(p);
+    for(std::size_t i = 0; i < count; i++) out[i] = generator() < threshold;
+}
+
+void bernoulliPcg(pcg32 &generator, const double p, uint8_t *out, const std::size_t count)
+{
+    const uint64_t threshold = probabilityThreshold(p) >> 32;
+    for(std::size_t i = 0; i < count; i++) out[i] = generator() < threshold;
+}
+
+// p = 0.5 only: each bit of a 64-bit output is one draw.
+void bernoulliHalfBits(xoshiro256 &generator, uint8_t *out, const std::size_t count)
+{
+    std::size_t i = 0;
+    for(; i + 64 <= count; i += 64)
+    {
+        uint64_t bits = generator();
+        for(int b = 0; b < 64; b++) out[i + b] = (bits >> b) & 1;
+    }
+    uint64_t bits = generator();
+    for(int b = 0; i < count; i++, b++) out[i] = (bits >> b) & 1;
+}
+
+// p = 0.5 only, left packed: 64 draws per word and no unpacking at all.
+void bernoulliHalfPacked(xoshiro256 &generator, uint64_t *out, const std::size_t words)
+{
+    for(std::size_t i = 0; i < words; i++) out[i] = generator();
+}
+
+// Any p, 64 draws per word: walking the binary expansion of p from its
+// lowest bit, x = bit ? (x | r) : (x & r) with fresh random r leaves every
+// bit of x set with probability p. Uses `precision` random words per 64
+// draws instead of 64.
+void bernoulliPacked(xoshiro256 &generator, const double p, uint64_t *out, const std::size_t words, const int precision)
+{
+    const uint64_t threshold = probabilityThreshold(p) >> (64 - precision);
+    for(std::size_t i = 0; i < words; i++)
+    {
+        uint64_t x = 0;
+        for(int bit = 0; bit < precision; bit++)
+        {
+            uint64_t r = generator();
+            x = (threshold >> bit) & 1 ? (x | r) : (x & r);
+        }
+        out[i] = x;
+    }
+}
+
+#ifdef __AVX2__
+// Four xoshiro256+ generators stepped at once with AVX2 intrinsics. AVX2
+// has no unsigned 64-bit compare, so both sides are shifted into signed
+// range first. The same step written as plain loops over the four lanes ran
+// slower than a single xoshiro256**, so it is spelled out here.
+void bernoulliAvx2(xoshiroLanes &generator, const double p, uint8_t *out, const std::size_t count)
+{
+    const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    const __m256i threshold = _mm256_xor_si256(_mm256_set1_epi64x((long long)probabilityThreshold(p)), sign);
+    __m256i s0 = _mm256_loadu_si256((const __m256i *)generator.s0);
+    __m256i s1 = _mm256_loadu_si256((const __m256i *)generator.s1);
+    __m256i s2 = _mm256_loadu_si256((const __m256i *)generator.s2);
+    __m256i s3 = _mm256_loadu_si256((const __m256i *)generator.s3);
+    for(std::size_t i = 0; i < count; i += SAMPLER_LANES)
+    {
+        __m256i result = _mm256_xor_si256(_mm256_add_epi64(s0, s3), sign);
+        __m256i t = _mm256_slli_epi64(s1, 17);
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+        int below = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(threshold, result)));
+        for(int l = 0; l < SAMPLER_LANES && i + l < count; l++) out[i + l] = (below >> l) & 1;
+    }
+    _mm256_storeu_si256((__m256i *)generator.s0, s0);
+    _mm256_storeu_si256((__m256i *)generator.s1, s1);
+    _mm256_storeu_si256((__m256i *)generator.s2, s2);
+    _mm256_storeu_si256((__m256i *)generator.s3, s3);
+}
+#endif
+
+double toUnitDouble(const uint64_t x) { return (double)(x >> 11) * 0x1.0p-53; }
+
+void uniformStd(std::mt19937 &generator, double *out, const std::size_t count)
+{
+    std::uniform_real_distribution <> distribution(0, 1);
+    for(std::size_t i = 0; i < count; i++) out[i] = distribution(generator);
+}
+
+void uniformStd64(std::mt19937_64 &generator, double *out, const std::size_t count)
+{
+    std::uniform_real_distribution <> distribution(0, 1);
+    for(std::size_t i = 0; i < count; i++) out[i] = distribution(generator);
+}
+
+void uniformXoshiro(xoshiro256 &generator, double *out, const std::size_t count)
+{
+    for(std::size_t i = 0; i < count; i++) out[i] = toUnitDouble(generator());
+}
+
+// Single precision from 24 of PCG's 32 bits.
+void uniformPcg(pcg32 &generator, float *out, const std::size_t count)
+{
+    for(std::size_t i = 0; i < count; i++) out[i] = (float)(generator() >> 8) * 0x1.0p-24f;
+}
+
+#endif
@@ -0,0 +1,228 @@
+#ifndef PENNEY_DECK_CPP
+#define PENNEY_DECK_CPP
+
+// Penney's game dealt from a real 52-card deck (26 Black, 26 Red, no
+// replacement), scored as the trick-count variant: whenever a player's
+// sequence shows up among the cards dealt since the last trick, that player
+// takes the trick and the next trick starts from scratch. Whoever holds more
+// tricks once the deck runs out wins the deck.
+//
+// A deck is one 64-bit word, card i in bit i, R = 1. It is shuffled with
+// Fisher-Yates on the bits themselves, DECK_LANES decks at a time with one
+// generator per lane so the inner loops are straight-line code the compiler
+// can vectorize.
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include "penneySimulation.cpp"
+
+const int DECK_SIZE = 52;
+const int DECK_LANES = 8;
+const int TRICK_LENGTH = 3;
+const unsigned long long DEFAULT_DECKS_PER_PAIR = 1000000;
+
+// State of the current trick: 0 - no cards yet, 1 + c - one card c,
+// 3 + cc - at least two cards, the last two being cc.
+const int TRICK_STATES = 7;
+
+struct laneGenerators
+{
+    uint64_t s0[DECK_LANES];
+    uint64_t s1[DECK_LANES];
+    uint64_t s2[DECK_LANES];
+    uint64_t s3[DECK_LANES];
+
+    explicit laneGenerators(const uint64_t seed)
+    {
+        for(int l = 0; l < DECK_LANES; l++)
+        {
+            xoshiro256 lane(seed + (uint64_t)l * 0xd1b54a32d192ed03ULL);
+            s0[l] = lane.s[0];
+            s1[l] = lane.s[1];
+            s2[l] = lane.s[2];
+            s3[l] = lane.s[3];
+        }
+    }
+
+    // xoshiro256** step in every lane at once.
+    void next(uint64_t *out)
+    {
+        for(int l = 0; l < DECK_LANES; l++)
+        {
+            uint64_t x = s1[l] * 5;
+            out[l] = ((x << 7) | (x >> 57)) * 9;
+            uint64_t t = s1[l] << 17;
+            s2[l] ^= s0[l];
+            s3[l] ^= s1[l];
+            s1[l] ^= s2[l];
+            s0[l] ^= s3[l];
+            s2[l] ^= t;
+            s3[l] = (s3[l] << 45) | (s3[l] >> 19);
+        }
+    }
+};
+
+uint64_t sortedDeck()
+{
+    return (1ULL << (DECK_SIZE / 2)) - 1;
+}
+
+// Swaps card i with a uniformly chosen card from 0..i in every lane; the
+// 32-bit random value is scaled with a multiply instead of a modulo.
+void swapLanes(uint64_t *decks, const uint64_t *random, const int i)
+{
+    for(int l = 0; l < DECK_LANES; l++)
+    {
+        uint64_t j = ((random[l] & 0xffffffffULL) * (uint64_t)(i + 1)) >> 32;
+        uint64_t differ = ((decks[l] >> i) ^ (decks[l] >> j)) & 1;
+        decks[l] ^= (differ << i) | (differ << j);
+    }
+}
+
+// Reshuffles every lane's deck; any permutation of a uniformly shuffled
+// deck is still uniform, so decks are never reset between rounds.
+void shuffleLanes(laneGenerators &generators, uint64_t *decks)
+{
+    uint64_t random[DECK_LANES];
+    uint64_t upper[DECK_LANES];
+    for(int i = DECK_SIZE - 1; i >= 1; i -= 2)
+    {
+        generators.next(random);
+        for(int l = 0; l < DECK_LANES; l++) upper[l] = random[l] >> 32;
+        swapLanes(decks, random, i);
+        if(i > 1) swapLanes(decks, upper, i - 1);
+    }
+}
+
+// Transition table over one byte (8 cards) of the deck for one pair of
+// 3-card sequences: the new trick state and the tricks each player took.
+struct trickTable
+{
+    uint16_t step[TRICK_STATES][256];
+    uint16_t lastCards[TRICK_STATES][16];
+
+    static int advance(const int state, const uint32_t card, const uint32_t first, const uint32_t second, int &firstTricks, int &secondTricks)
+    {
+        if(state == 0) return 1 + (int)card;
+        if(state < 3) return 3 + (((state - 1) << 1) | (int)card);
+        uint32_t lastThree = ((uint32_t)(state - 3) << 1) | card;
+        if(lastThree == first)
+        {
+            firstTricks++;
+            return 0;
+        }
+        if(lastThree == second)
+        {
+            secondTricks++;
+            return 0;
+        }
+        return 3 + (int)(lastThree & 3);
+    }
+
+    static uint16_t tableEntry(int state, const uint32_t cards, const int count, const uint32_t first, const uint32_t second)
+    {
+        int firstTricks = 0;
+        int secondTricks = 0;
+        for(int bit = 0; bit < count; bit++) state = advance(state, (cards >> bit) & 1, first, second, firstTricks, secondTricks);
+        return (uint16_t)(state | (firstTricks << 4) | (secondTricks << 8));
+    }
+
+    trickTable(const uint32_t first, const uint32_t second)
+    {
+        for(int state = 0; state < TRICK_STATES; state++)
+        {
+            for(int byte = 0; byte < 256; byte++)
+            {
+                step[state][byte] = tableEntry(state, (uint32_t)byte, 8, first, second);
+                if(byte < 16) lastCards[state][byte] = tableEntry(state, (uint32_t)byte, 4, first, second);
+            }
+        }
+    }
+
+    // Returns the first player's tricks minus the second player's.
+    int score(const uint64_t deck) const
+    {
+        int state = 0;
+        int difference = 0;
+        int card = 0;
+        for(; card + 8 <= DECK_SIZE; card += 8)
+        {
+            uint16_t entry = step[state][(deck >> card) & 0xff];
+            state = entry & 0xf;
+            difference += ((entry >> 4) & 0xf) - (entry >> 8);
+        }
+        uint16_t entry = lastCards[state][(deck >> card) & 0xf];
+        return difference + ((entry >> 4) & 0xf) - (entry >> 8);
+    }
+};
+
+static_assert(DECK_SIZE % 8 == 4, "trickTable::score finishes the deck with one half byte");
+
+void deckWorker(const uint64_t decksPerPair, const uint64_t seed, winMatrix &result)
+{
+    laneGenerators generators(seed);
+    uint64_t decks[DECK_LANES];
+    for(int l = 0; l < DECK_LANES; l++) decks[l] = sortedDeck();
+    for(int first = 0; first < result.sequences; first++)
+    {
+        for(int second = first + 1; second < result.sequences; second++)
+        {
+            trickTable table((uint32_t)first, (uint32_t)second);
+            uint64_t firstWins = 0;
+            uint64_t secondWins = 0;
+            for(uint64_t played = 0; played < decksPerPair; played += DECK_LANES)
+            {
+                shuffleLanes(generators, decks);
+                int lanes = decksPerPair - played < DECK_LANES ? (int)(decksPerPair - played) : DECK_LANES;
+                for(int l = 0; l < lanes; l++)
+                {
+                    int difference = table.score(decks[l]);
+                    firstWins += difference > 0;
+                    secondWins += difference < 0;
+                }
+            }
+            result.wins[(std::size_t)first * result.sequences + second] += firstWins;
+            result.wins[(std::size_t)second * result.sequences + first] += secondWins;
+        }
+    }
+}
+
+winMatrix simulateDecks(const uint64_t decksPerPair, unsigned int threads, const uint64_t seed)
+{
+    if(threads == 0) threads = 1;
+    std::vector <winMatrix> partial(threads, winMatrix(TRICK_LENGTH));
+    std::vector <std::thread> pool;
+    for(unsigned int t = 0; t < threads; t++)
+    {
+        uint64_t share = decksPerPair / threads + (t < decksPerPair % threads);
+        pool.emplace_back(deckWorker, share, seed + t * 0x9e3779b97f4a7c15ULL, std::ref(partial[t]));
+    }
+    winMatrix total(TRICK_LENGTH);
+    total.gamesPerPair = decksPerPair;
+    for(unsigned int t = 0; t < threads; t++)
+    {
+        pool[t].join();
+        for(std::size_t i = 0; i < total.wins.size(); i++) total.wins[i] += partial[t].wins[i];
+    }
+    return total;
+}
+
+void runDeckSimulation(const uint64_t decksPerPair, const unsigned int threads)
+{
+    uint64_t seed = ((uint64_t)std::random_device{}() << 32) ^ std::random_device{}();
+    auto start = std::chrono::steady_clock::now();
+    winMatrix matrix = simulateDecks(decksPerPair, threads, seed);
+    double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+    uint64_t decks = decksPerPair * (uint64_t)matrix.sequences * (matrix.sequences - 1) / 2;
+    std::cout << "Trick-count variant over whole 52-card decks, a tied deck is a win for nobody." << std::endl;
+    printWinMatrix(matrix);
+    std::cout << decks << " decks in " << std::setprecision(3) << seconds << " s ("
+    << std::setprecision(0) << decks / seconds << " decks/s)" << std::endl;
+}
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef PENNEY_ODDS_CPP
+#define PENNEY_ODDS_CPP
+
+// Exact odds for Penney's game with Conway's leading numbers. For sequences
+// A and B over an alphabet of q symbols, AB is the sum of q^(k - 1) over
+// every k such that the last k symbols of A equal the first k of B. The odds
+// of B appearing before A are then (AA - AB) : (BB - BA).
+
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+#include "penneySimulation.cpp"
+
+const int MAX_EXACT_MATRIX_LENGTH = 10;
+const int MAX_EXACT_ROW_LENGTH = 24;
+
+long double conwayCorrelation(const std::string &a, const std::string &b, const int alphabetSize)
+{
+    long double correlation = 0;
+    long double power = 1;
+    std::size_t shortest = a.size() < b.size() ? a.size() : b.size();
+    for(std::size_t k = 1; k <= shortest; k++)
+    {
+        if(a.compare(a.size() - k, k, b, 0, k) == 0) correlation += power;
+        power *= alphabetSize;
+    }
+    return correlation;
+}
+
+// Probability that `first` shows up before `second`. When one sequence is
+// contained in the other it necessarily completes no later, so it wins.
+double winProbability(const std::string &first, const std::string &second, const int alphabetSize)
+{
+    if(first == second) return 0.5;
+    if(second.find(first) != std::string::npos) return 1.0;
+    if(first.find(second) != std::string::npos) return 0.0;
+    long double firstOdds = conwayCorrelation(second, second, alphabetSize) - conwayCorrelation(second, first, alphabetSize);
+    long double secondOdds = conwayCorrelation(first, first, alphabetSize) - conwayCorrelation(first, second, alphabetSize);
+    return (double)(firstOdds / (firstOdds + secondOdds));
+}
+
+// Two-color fast path on the bit encoding from penneySimulation.cpp: the
+// overlap test for every k is a mask and a shift, and the leading numbers
+// stay exact integers up to 2^31.
+uint64_t conwayCorrelationBits(const uint32_t a, const uint32_t b, const int length)
+{
+    uint64_t correlation = 0;
+    for(int k = 1; k <= length; k++)
+    {
+        uint32_t suffix = a & ((1u << k) - 1);
+        uint32_t prefix = b >> (length - k);
+        if(suffix == prefix) correlation |= 1ULL << (k - 1);
+    }
+    return correlation;
+}
+
+double winProbabilityBits(const uint32_t first, const uint32_t second, const int length)
+{
+    if(first == second) return 0.5;
+    uint64_t firstOdds = conwayCorrelationBits(second, second, length) - conwayCorrelationBits(second, first, length);
+    uint64_t secondOdds = conwayCorrelationBits(first, first, length) - conwayCorrelationBits(first, second, length);
+    return (double)firstOdds / (double)(firstOdds + secondOdds);
+}
+
+// odds[first * sequences + second] is the probability that `first` beats `second`.
+struct oddsMatrix
+{
+    int length;
+    int sequences;
+    std::vector <double> odds;
+
+    double winRate(const int first, const int second) const
+    {
+        return odds[(std::size_t)first * sequences + second];
+    }
+};
+
+oddsMatrix exactMatrix(const int length)
+{
+    oddsMatrix matrix;
+    matrix.length = length;
+    matrix.sequences = 1 << length;
+    matrix.odds.resize((std::size_t)matrix.sequences * matrix.sequences);
+    std::vector <uint64_t> self(matrix.sequences);
+    for(int s = 0; s < matrix.sequences; s++) self[s] = conwayCorrelationBits((uint32_t)s, (uint32_t)s, length);
+    for(int first = 0; first < matrix.sequences; first++)
+    {
+        matrix.odds[(std::size_t)first * matrix.sequences + first] = 0.5;
+        for(int second = first + 1; second < matrix.sequences; second++)
+        {
+            uint64_t firstOdds = self[second] - conwayCorrelationBits((uint32_t)second, (uint32_t)first, length);
+            uint64_t secondOdds = self[first] - conwayCorrelationBits((uint32_t)first, (uint32_t)second, length);
+            double p = (double)firstOdds / (double)(firstOdds + secondOdds);
+            matrix.odds[(std::size_t)first * matrix.sequences + second] = p;
+            matrix.odds[(std::size_t)second * matrix.sequences + first] = 1.0 - p;
+        }
+    }
+    return matrix;
+}
+
+void printOddsMatrix(const oddsMatrix &matrix)
+{
+    std::cout << "Exact probability of row sequence beating column sequence:" << std::endl;
+    std::cout << std::setw(matrix.length + 1) << " ";
+    for(int second = 0; second < matrix.sequences; second++) std::cout << std::setw(matrix.length + 4) << bitsToSequence((uint32_t)second, matrix.length);
+    std::cout << std::endl;
+    for(int first = 0; first < matrix.sequences; first++)
+    {
+        std::cout << std::setw(matrix.length + 1) << bitsToSequence((uint32_t)first, matrix.length);
+        for(int second = 0; second < matrix.sequences; second++)
+        {
+            if(first == second) std::cout << std::setw(matrix.length + 4) << "-";
+            else std::cout << std::setw(matrix.length + 4) << std::fixed << std::setprecision(4) << matrix.winRate(first, second);
+        }
+        std::cout << std::endl;
+    }
+}
+
+// One sequence against every other sequence of its length, which stays
+// instant for two colors up to MAX_EXACT_ROW_LENGTH even where the whole
+// matrix no longer fits in memory.
+void printOddsRow(const std::string &sequence)
+{
+    int length = (int)sequence.size();
+    uint32_t first = sequenceToBits(sequence);
+    uint32_t sequences = 1u << length;
+    uint32_t bestOpponent = first;
+    double worst = 1.0;
+    uint64_t beaten = 0;
+    for(uint32_t second = 0; second < sequences; second++)
+    {
+        if(second == first) continue;
+        double p = winProbabilityBits(first, second, length);
+        if(p > 0.5) beaten++;
+        if(p < worst)
+        {
+            worst = p;
+            bestOpponent = second;
+        }
+    }
+    std::cout << sequence << " beats " << beaten << " of " << sequences - 1 << " sequences of length " << length << std::endl;
+    std::cout << "Strongest opponent: " << bitsToSequence(bestOpponent, length) << ", " << sequence
+    << " wins with probability " << std::setprecision(6) << worst << std::endl;
+}
+
+int alphabetSizeOf(const std::string &first, const std::string &second)
+{
+    std::set <char> symbols(first.begin(), first.end());
+    symbols.insert(second.begin(), second.end());
+    return symbols.size() < 2 ? 2 : (int)symbols.size();
+}
+
+// Compares a Monte Carlo run with the exact matrix: prints the largest
+// deviation and its size in standard errors of the sampled win rate.
+void checkSimulation(const int length, const uint64_t gamesPerPair, const unsigned int threads)
+{
+    uint64_t seed = ((uint64_t)std::random_device{}() << 32) ^ std::random_device{}();
+    winMatrix simulated = simulateAllPairs(length, gamesPerPair, threads, seed);
+    oddsMatrix exact = exactMatrix(length);
+    double largestDeviation = 0;
+    double largestZ = 0;
+    for(int first = 0; first < exact.sequences; first++)
+    {
+        for(int second = 0; second < exact.sequences; second++)
+        {
+            if(first == second) continue;
+            double p = exact.winRate(first, second);
+            double deviation = std::fabs(simulated.winRate(first, second) - p);
+            double standardError = std::sqrt(p * (1 - p) / gamesPerPair);
+            if(deviation > largestDeviation) largestDeviation = deviation;
+            if(standardError > 0 && deviation / standardError > largestZ) largestZ = deviation / standardError;
+        }
+    }
+    std::cout << "Largest deviation from exact odds: " << std::setprecision(6) << largestDeviation
+    << " (" << std::setprecision(2) << largestZ << " standard errors, " << gamesPerPair << " games per pair)" << std::endl;
+}
+
+#endif
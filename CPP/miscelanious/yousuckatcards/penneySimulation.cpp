@@ -0,0 +1,208 @@
+#ifndef PENNEY_SIMULATION_CPP
+#define PENNEY_SIMULATION_CPP
+
+// Monte Carlo engine for Penney's game. A sequence of colors is kept as
+// bits (R = 1, B = 0, first color in the highest bit), so the last
+// SEQUENCE_LENGTH flips are a rolling integer and every 64-bit draw of the
+// generator yields 64 flips.
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+const unsigned long long DEFAULT_GAMES_PER_PAIR = 10000000;
+const int MAX_SIMULATED_LENGTH = 16;
+
+struct xoshiro256
+{
+    uint64_t s[4];
+
+    explicit xoshiro256(uint64_t seed)
+    {
+        for(int i = 0; i < 4; i++)
+        {
+            seed += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            s[i] = z ^ (z >> 31);
+        }
+    }
+
+    static uint64_t rotate(const uint64_t x, const int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t operator()()
+    {
+        const uint64_t result = rotate(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotate(s[3], 45);
+        return result;
+    }
+};
+
+// Hands out single fair coin flips, refilling from the generator every 64.
+struct flipSource
+{
+    xoshiro256 &rng;
+    uint64_t bits = 0;
+    int left = 0;
+
+    explicit flipSource(xoshiro256 &generator) : rng(generator) {}
+
+    uint32_t flip()
+    {
+        if(left == 0)
+        {
+            bits = rng();
+            left = 64;
+        }
+        uint32_t b = (uint32_t)(bits & 1);
+        bits >>= 1;
+        left--;
+        return b;
+    }
+};
+
+uint32_t sequenceToBits(const std::string &sequence)
+{
+    uint32_t bits = 0;
+    for(unsigned int i = 0; i < sequence.size(); i++) bits = (bits << 1) | (sequence[i] == 'R');
+    return bits;
+}
+
+std::string bitsToSequence(const uint32_t bits, const int length)
+{
+    std::string sequence;
+    for(int i = length - 1; i >= 0; i--) sequence.push_back((bits >> i) & 1 ? 'R' : 'B');
+    return sequence;
+}
+
+struct pairWins
+{
+    uint64_t first = 0;
+    uint64_t second = 0;
+};
+
+// Plays `games` games of `first` against `second`, both `length` flips long
+// and different from each other.
+pairWins simulatePair(const uint32_t first, const uint32_t second, const int length, const uint64_t games, flipSource &flips)
+{
+    const uint32_t mask = (1u << length) - 1;
+    pairWins wins;
+    for(uint64_t g = 0; g < games; g++)
+    {
+        uint32_t state = 0;
+        for(int i = 1; i < length; i++) state = (state << 1) | flips.flip();
+        while(true)
+        {
+            state = ((state << 1) | flips.flip()) & mask;
+            if(state == first)
+            {
+                wins.first++;
+                break;
+            }
+            if(state == second)
+            {
+                wins.second++;
+                break;
+            }
+        }
+    }
+    return wins;
+}
+
+// wins[first * sequences + second] counts games won by `first` against `second`.
+struct winMatrix
+{
+    int length;
+    int sequences;
+    uint64_t gamesPerPair;
+    std::vector <uint64_t> wins;
+
+    explicit winMatrix(const int sequenceLength) :
+        length(sequenceLength), sequences(1 << sequenceLength), gamesPerPair(0), wins((std::size_t)sequences * sequences, 0) {}
+
+    double winRate(const int first, const int second) const
+    {
+        return gamesPerPair ? (double)wins[(std::size_t)first * sequences + second] / gamesPerPair : 0.0;
+    }
+};
+
+void simulateWorker(const int length, const uint64_t gamesPerPair, const uint64_t seed, winMatrix &result)
+{
+    xoshiro256 rng(seed);
+    flipSource flips(rng);
+    for(int first = 0; first < result.sequences; first++)
+    {
+        for(int second = first + 1; second < result.sequences; second++)
+        {
+            pairWins wins = simulatePair((uint32_t)first, (uint32_t)second, length, gamesPerPair, flips);
+            result.wins[(std::size_t)first * result.sequences + second] += wins.first;
+            result.wins[(std::size_t)second * result.sequences + first] += wins.second;
+        }
+    }
+}
+
+// Runs every unordered pair of `length`-flip sequences gamesPerPair times,
+// splitting the games between `threads` threads with their own generators.
+winMatrix simulateAllPairs(const int length, const uint64_t gamesPerPair, unsigned int threads, const uint64_t seed)
+{
+    if(threads == 0) threads = 1;
+    std::vector <winMatrix> partial(threads, winMatrix(length));
+    std::vector <std::thread> pool;
+    for(unsigned int t = 0; t < threads; t++)
+    {
+        uint64_t share = gamesPerPair / threads + (t < gamesPerPair % threads);
+        pool.emplace_back(simulateWorker, length, share, seed + t * 0x9e3779b97f4a7c15ULL, std::ref(partial[t]));
+    }
+    winMatrix total(length);
+    total.gamesPerPair = gamesPerPair;
+    for(unsigned int t = 0; t < threads; t++)
+    {
+        pool[t].join();
+        for(std::size_t i = 0; i < total.wins.size(); i++) total.wins[i] += partial[t].wins[i];
+    }
+    return total;
+}
+
+void printWinMatrix(const winMatrix &matrix)
+{
+    std::cout << "Win rate of row sequence against column sequence:" << std::endl;
+    std::cout << std::setw(matrix.length + 1) << " ";
+    for(int second = 0; second < matrix.sequences; second++) std::cout << std::setw(7) << bitsToSequence((uint32_t)second, matrix.length);
+    std::cout << std::endl;
+    for(int first = 0; first < matrix.sequences; first++)
+    {
+        std::cout << std::setw(matrix.length + 1) << bitsToSequence((uint32_t)first, matrix.length);
+        for(int second = 0; second < matrix.sequences; second++)
+        {
+            if(first == second) std::cout << std::setw(7) << "-";
+            else std::cout << std::setw(7) << std::fixed << std::setprecision(4) << matrix.winRate(first, second);
+        }
+        std::cout << std::endl;
+    }
+}
+
+void runSimulation(const int length, const uint64_t gamesPerPair, const unsigned int threads)
+{
+    uint64_t seed = ((uint64_t)std::random_device{}() << 32) ^ std::random_device{}();
+    auto start = std::chrono::steady_clock::now();
+    winMatrix matrix = simulateAllPairs(length, gamesPerPair, threads, seed);
+    double seconds = std::chrono::duration <double> (std::chrono::steady_clock::now() - start).count();
+    uint64_t games = gamesPerPair * (uint64_t)matrix.sequences * (matrix.sequences - 1) / 2;
+    printWinMatrix(matrix);
+    std::cout << games << " games in " << std::setprecision(3) << seconds << " s ("
+    << std::setprecision(0) << games / seconds << " games/s)" << std::endl;
+}
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef PENNEY_STRATEGY_CPP
+#define PENNEY_STRATEGY_CPP
+
+// Best responses in Penney's game for any sequence length and alphabet size.
+// A sequence is a number in base alphabetSize, first symbol most significant,
+// which for two colors is exactly the bit encoding of penneySimulation.cpp.
+// The responses for every sequence are searched with the exact odds once and
+// stored in a table file, so the bot only has to index it.
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "penneyOdds.cpp"
+
+const char STRATEGY_FILE[] = "strategy.bin";
+const char STRATEGY_MAGIC[4] = {'P', 'N', 'Y', 'S'};
+const uint32_t STRATEGY_VERSION = 1;
+const uint64_t MAX_STRATEGY_SEQUENCES = 1ULL << 28;
+// Up to this many sequences every one of them is tried as a response;
+// above it only the candidates from the Guibas-Odlyzko theorem are.
+const uint64_t EXHAUSTIVE_SEARCH_SEQUENCES = 64;
+
+// B and R for the two colors, further symbols follow alphabetically.
+const std::string STRATEGY_SYMBOLS = "BRACDEFGHIJKLMNOPQSTUVWXYZ";
+
+struct strategyTable
+{
+    uint32_t length = 0;
+    uint32_t alphabetSize = 0;
+    std::vector <uint32_t> response;
+    std::vector <float> odds;
+
+    bool covers(const uint32_t sequenceLength, const uint32_t symbols) const
+    {
+        return length == sequenceLength && alphabetSize == symbols && !response.empty();
+    }
+};
+
+uint64_t sequenceCount(const uint32_t length, const uint32_t alphabetSize)
+{
+    uint64_t count = 1;
+    for(uint32_t i = 0; i < length && count <= MAX_STRATEGY_SEQUENCES; i++) count *= alphabetSize;
+    return count;
+}
+
+std::string indexToSequence(uint32_t index, const uint32_t length, const uint32_t alphabetSize)
+{
+    std::string sequence(length, STRATEGY_SYMBOLS[0]);
+    for(uint32_t i = length; i > 0; i--)
+    {
+        sequence[i - 1] = STRATEGY_SYMBOLS[index % alphabetSize];
+        index /= alphabetSize;
+    }
+    return sequence;
+}
+
+// Returns false for symbols outside the alphabet.
+bool sequenceToIndex(const std::string &sequence, const uint32_t alphabetSize, uint32_t &index)
+{
+    index = 0;
+    for(unsigned int i = 0; i < sequence.size(); i++)
+    {
+        std::size_t symbol = STRATEGY_SYMBOLS.find(sequence[i]);
+        if(symbol == std::string::npos || symbol >= alphabetSize) return false;
+        index = index * alphabetSize + (uint32_t)symbol;
+    }
+    return true;
+}
+
+double responseOdds(const uint32_t response, const uint32_t player, const uint32_t length, const uint32_t alphabetSize)
+{
+    if(alphabetSize == 2) return winProbabilityBits(response, player, (int)length);
+    return winProbability(indexToSequence(response, length, alphabetSize), indexToSequence(player, length, alphabetSize), (int)alphabetSize);
+}
+
+// Guibas and Odlyzko showed the best response to a1...an is always one of
+// x a1...a(n-1), so for long sequences only alphabetSize candidates are tried.
+uint32_t bestResponse(const uint32_t player, const uint32_t length, const uint32_t alphabetSize, const uint64_t sequences, float &odds)
+{
+    uint32_t best = player;
+    double bestOdds = -1;
+    if(sequences <= EXHAUSTIVE_SEARCH_SEQUENCES)
+    {
+        for(uint32_t candidate = 0; candidate < sequences; candidate++)
+        {
+            if(candidate == player) continue;
+            double p = responseOdds(candidate, player, length, alphabetSize);
+            if(p > bestOdds)
+            {
+                bestOdds = p;
+                best = candidate;
+            }
+        }
+    }else
+    {
+        uint32_t highest = (uint32_t)(sequences / alphabetSize);
+        for(uint32_t symbol = 0; symbol < alphabetSize; symbol++)
+        {
+            uint32_t candidate = symbol * highest + player / alphabetSize;
+            if(candidate == player) continue;
+            double p = responseOdds(candidate, player, length, alphabetSize);
+            if(p > bestOdds)
+            {
+                bestOdds = p;
+                best = candidate;
+            }
+        }
+    }
+    odds = (float)bestOdds;
+    return best;
+}
+
+strategyTable buildStrategyTable(const uint32_t length, const uint32_t alphabetSize)
+{
+    strategyTable table;
+    uint64_t sequences = sequenceCount(length, alphabetSize);
+    if(length < 2 || alphabetSize < 2 || alphabetSize > STRATEGY_SYMBOLS.size() || sequences > MAX_STRATEGY_SEQUENCES) return table;
+    table.length = length;
+    table.alphabetSize = alphabetSize;
+    table.response.resize(sequences);
+    table.odds.resize(sequences);
+    for(uint32_t player = 0; player < sequences; player++)
+    {
+        table.response[player] = bestResponse(player, length, alphabetSize, sequences, table.odds[player]);
+    }
+    return table;
+}
+
+bool saveStrategyTable(const strategyTable &table, const char *path)
+{
+    std::ofstream file(path, std::ios::binary);
+    uint32_t header[4] = {STRATEGY_VERSION, table.length, table.alphabetSize, (uint32_t)table.response.size()};
+    file.write(STRATEGY_MAGIC, sizeof(STRATEGY_MAGIC));
+    file.write((const char *)header, sizeof(header));
+    file.write((const char *)table.response.data(), (std::streamsize)(table.response.size() * sizeof(uint32_t)));
+    file.write((const char *)table.odds.data(), (std::streamsize)(table.odds.size() * sizeof(float)));
+    return (bool)file;
+}
+
+bool loadStrategyTable(const char *path, strategyTable &table)
+{
+    std::ifstream file(path, std::ios::binary);
+    char magic[4];
+    uint32_t header[4];
+    if(!file.read(magic, sizeof(magic)) || !file.read((char *)header, sizeof(header))) return false;
+    if(std::memcmp(magic, STRATEGY_MAGIC, sizeof(magic)) != 0 || header[0] != STRATEGY_VERSION) return false;
+    if(header[3] != sequenceCount(header[1], header[2])) return false;
+    // The header is not trusted with the allocation until the file backs it.
+    std::streamoff start = file.tellg();
+    file.seekg(0, std::ios::end);
+    std::streamoff bytes = file.tellg() - start;
+    file.seekg(start);
+    if(bytes < 0 || (uint64_t)bytes != (uint64_t)header[3] * (sizeof(uint32_t) + sizeof(float))) return false;
+    table.length = header[1];
+    table.alphabetSize = header[2];
+    table.response.resize(header[3]);
+    table.odds.resize(header[3]);
+    file.read((char *)table.response.data(), (std::streamsize)(table.response.size() * sizeof(uint32_t)));
+    file.read((char *)table.odds.data(), (std::streamsize)(table.odds.size() * sizeof(float)));
+    if(!file) table.response.clear();
+    return !table.response.empty();
+}
+
+// Loads the stored table when it matches, otherwise builds one in memory.
+strategyTable loadOrBuildStrategy(const char *path, const uint32_t length, const uint32_t alphabetSize)
+{
+    strategyTable table;
+    if(loadStrategyTable(path, table) && table.covers(length, alphabetSize)) return table;
+    return buildStrategyTable(length, alphabetSize);
+}
+
+void printStrategyTable(const strategyTable &table)
+{
+    for(uint32_t player = 0; player < table.response.size(); player++)
+    {
+        std::cout << indexToSequence(player, table.length, table.alphabetSize) << " -> "
+        << indexToSequence(table.response[player], table.length, table.alphabetSize)
+        << " wins " << std::fixed << std::setprecision(4) << table.odds[player] << std::endl;
+    }
+}
+
+#endif
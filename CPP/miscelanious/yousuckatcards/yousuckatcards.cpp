@@ -1,8 +1,15 @@
+#include <charconv>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <random>
 #include <string>
+#include "penneyOdds.cpp"
+#include "penneyDeck.cpp"
+#include "penneyStrategy.cpp"
 
 const int SEQUENCE_LENGTH = 3;
+const unsigned int MAX_THREADS = 256;
 
 const bool BOT_WON = 0;
 const bool PLAYER_WON = 1;
@@ -41,14 +48,14 @@ std::string playerChoice()
     return playerSequence;
 }
 
+// Filled in main from strategy.bin, or built on the spot when the file is
+// missing, so every bot answer is a single table lookup.
+strategyTable botStrategy;
+
 std::string botChoice(std::string  const playerSequence)
 {
-    std::string botSequence;
-    if(playerSequence[1] == 'B') botSequence.push_back('R');
-    else botSequence.push_back('B');
-    botSequence.push_back(playerSequence[0]);
-    botSequence.push_back(playerSequence[2]);
-    return botSequence;
+    uint32_t player = sequenceToBits(playerSequence);
+    return bitsToSequence(botStrategy.response[player], SEQUENCE_LENGTH);
 }
 
 int compareGeneratedAndPlayers(std::string playerSequence, std::string botSequence, std::string generatedSequence)
@@ -63,8 +70,7 @@ int compareGeneratedAndPlayers(std::string playerSequence, std::string botSequen
 bool game(std::string playerSequence, std::string botSequence)
 {
 	std::string generatedSequence;
-	std::random_device rd;
-	std::mt19937 gen(rd());
+	static std::mt19937 gen(std::random_device{}());
 	std::bernoulli_distribution distribution(0.5);
     for(int i = 0; i < SEQUENCE_LENGTH; i++)
     {
@@ -91,8 +97,160 @@ void score(int playerWins, int botWins)
 
 
 
-int main()
+void usage()
+{
+    print("Usage: yousuckatcards                              play against the bot");
+    print("       yousuckatcards simulate [games per pair] [threads 1-256]  win rates of all sequence pairs");
+    print("       yousuckatcards deck [decks per pair] [threads 1-256]  trick-count variant without replacement");
+    print("       yousuckatcards exact [length]                 exact odds of all sequence pairs");
+    print("       yousuckatcards exact <sequence>               exact odds of one sequence against all others");
+    print("       yousuckatcards exact <first> <second> [alphabet size]  exact odds of two sequences");
+    print("       yousuckatcards strategy <length> [alphabet size] [file]  precompute bot answers, the game's own into strategy.bin");
+    print("       yousuckatcards check [length] [games per pair] [threads 1-256]  compare simulation with exact odds");
+}
+
+bool isNumber(const std::string &s)
+{
+    return !s.empty() && s.find_first_not_of("0123456789") == std::string::npos;
+}
+
+// The whole argument as a number from minimum to maximum.
+template <typename number>
+bool parseNumber(const char *text, number &value, const number minimum, const number maximum)
+{
+    const char *end = text + std::strlen(text);
+    std::from_chars_result result = std::from_chars(text, end, value);
+    return result.ec == std::errc() && result.ptr == end && value >= minimum && value <= maximum;
+}
+
+// Games and threads of the simulation modes, starting at argv[first].
+bool parseSimulationArguments(int argc, char **argv, const int first, unsigned long long &games, unsigned int &threads)
+{
+    if(argc > first && !parseNumber(argv[first], games, 1ULL, ~0ULL)) return false;
+    return argc <= first + 1 || parseNumber(argv[first + 1], threads, 1u, MAX_THREADS);
+}
+
+int exactMode(int argc, char **argv)
+{
+    if(argc > 3)
+    {
+        std::string first = argv[2];
+        std::string second = argv[3];
+        int alphabetSize = alphabetSizeOf(first, second);
+        if(argc > 4 && !parseNumber(argv[4], alphabetSize, alphabetSizeOf(first, second), std::numeric_limits <int>::max()))
+        {
+            std::cout << "Alphabet size must be a number of at least " << alphabetSizeOf(first, second) << ", the signs used" << std::endl;
+            return 1;
+        }
+        std::cout << first << " beats " << second << " with probability "
+        << std::setprecision(10) << winProbability(first, second, alphabetSize) << std::endl;
+        return 0;
+    }
+    if(argc > 2 && !isNumber(argv[2]))
+    {
+        std::string sequence = argv[2];
+        if(sequence.size() > MAX_EXACT_ROW_LENGTH || sequence.find_first_not_of("BR") != std::string::npos)
+        {
+            print("Sequence must consist of at most 24 B/R signs, use two sequences for other alphabets");
+            return 1;
+        }
+        printOddsRow(sequence);
+        return 0;
+    }
+    int length = SEQUENCE_LENGTH;
+    if(argc > 2 && !parseNumber(argv[2], length, 1, MAX_EXACT_MATRIX_LENGTH))
+    {
+        print("Whole matrix is printed for lengths 1 to 10, pass a sequence to get its row");
+        return 1;
+    }
+    printOddsMatrix(exactMatrix(length));
+    return 0;
+}
+
+int main(int argc, char **argv)
 {
+    if(argc > 1)
+    {
+        std::string mode = argv[1];
+        if(mode == "simulate")
+        {
+            unsigned long long games = DEFAULT_GAMES_PER_PAIR;
+            unsigned int threads = std::thread::hardware_concurrency();
+            if(!parseSimulationArguments(argc, argv, 2, games, threads))
+            {
+                usage();
+                return 1;
+            }
+            runSimulation(SEQUENCE_LENGTH, games, threads);
+            return 0;
+        }
+        if(mode == "deck")
+        {
+            unsigned long long decks = DEFAULT_DECKS_PER_PAIR;
+            unsigned int threads = std::thread::hardware_concurrency();
+            if(!parseSimulationArguments(argc, argv, 2, decks, threads))
+            {
+                usage();
+                return 1;
+            }
+            runDeckSimulation(decks, threads);
+            return 0;
+        }
+        if(mode == "exact") return exactMode(argc, argv);
+        if(mode == "strategy" && argc > 2)
+        {
+            uint32_t length;
+            uint32_t alphabetSize = 2;
+            if(!parseNumber(argv[2], length, 0u, ~0u) || (argc > 3 && !parseNumber(argv[3], alphabetSize, 0u, ~0u)))
+            {
+                usage();
+                return 1;
+            }
+            strategyTable table = buildStrategyTable(length, alphabetSize);
+            if(table.response.empty())
+            {
+                print("Sequences must be at least 2 long, alphabet 2 to 26 signs and at most 2^28 sequences");
+                return 1;
+            }
+            if(table.response.size() <= EXHAUSTIVE_SEARCH_SEQUENCES) printStrategyTable(table);
+            // strategy.bin is what the game loads, so only its own table goes there.
+            bool gameTable = table.covers(SEQUENCE_LENGTH, 2);
+            std::string path = argc > 4 ? argv[4] : gameTable ? STRATEGY_FILE : "strategy-" + std::to_string(length) + "-" + std::to_string(alphabetSize) + ".bin";
+            if(!gameTable && path == STRATEGY_FILE)
+            {
+                std::cout << STRATEGY_FILE << " is kept for the game's table (length " << SEQUENCE_LENGTH << ", 2 colors), choose another file" << std::endl;
+                return 1;
+            }
+            if(!saveStrategyTable(table, path.c_str()))
+            {
+                print("Could not write " + path);
+                return 1;
+            }
+            std::cout << "Saved answers to " << table.response.size() << " sequences in " << path << std::endl;
+            return 0;
+        }
+        if(mode == "check")
+        {
+            int length = SEQUENCE_LENGTH;
+            unsigned long long games = DEFAULT_GAMES_PER_PAIR;
+            unsigned int threads = std::thread::hardware_concurrency();
+            if(argc > 2 && !parseNumber(argv[2], length, 2, MAX_SIMULATED_LENGTH))
+            {
+                print("Simulated sequences must be 2 to 16 flips long");
+                return 1;
+            }
+            if(!parseSimulationArguments(argc, argv, 3, games, threads))
+            {
+                usage();
+                return 1;
+            }
+            checkSimulation(length, games, threads);
+            return 0;
+        }
+        usage();
+        return 1;
+    }
+    botStrategy = loadOrBuildStrategy(STRATEGY_FILE, SEQUENCE_LENGTH, 2);
 	int playerWins = 0;
 	int botWins = 0;
     do